@@ -0,0 +1,323 @@
+#pragma once
+
+#include <bit>
+#include <cstdint>
+#include <cstdio>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "gameoflife.h"
+#include "patterns.h"
+#include "rules.h"
+
+
+// Compact binary checkpoints of a board.
+//
+// A checkpoint holds the board size, wrap mode, rule, generation number
+// and last generation's statistics, followed by the cells packed at the
+// fewest bits per cell the rule's states need and then PackBits
+// compressed, so empty regions cost almost nothing. All fields are
+// little endian.
+//
+// Writes go to a temporary file that is synced and then renamed over the
+// old checkpoint, so a crash or power loss mid-write leaves the previous
+// one intact. Reads map the file
+// and decompress and unpack it in a single pass.
+namespace checkpoint {
+
+
+  constexpr std::string_view magic{"GOLSNAP\x01", 8};
+
+  constexpr std::size_t rule_bytes = (rules::max_count + 1 + 7) / 8;
+
+
+  struct state {
+    gameoflife::vector size;
+    bool wrap = true;
+    rules::rule rule;
+    uint64_t number = 0; // Generations since the board was created
+    gameoflife::generation stats;
+    std::vector<uint8_t> cells;
+  };
+
+
+  namespace detail {
+
+    inline void put(std::vector<uint8_t>& out, uint64_t value, int bytes) {
+      for (int i = 0; i < bytes; i++) {
+        out.push_back(static_cast<uint8_t>(value >> (i * 8)));
+      }
+    }
+
+    inline void put_counts(std::vector<uint8_t>& out, const rules::counts& c) {
+      for (std::size_t b = 0; b < rule_bytes; b++) {
+        uint8_t byte = 0;
+        for (std::size_t i = 0; i < 8 && (b * 8) + i < c.size(); i++) {
+          byte |= c[(b * 8) + i] << i;
+        }
+        out.push_back(byte);
+      }
+    }
+
+    // Bounds-checked little endian reader over a mapped file.
+    class reader {
+      protected:
+        std::string_view m_data;
+        bool m_ok{true};
+
+      public:
+        explicit reader(std::string_view data)
+          : m_data{data}
+        {}
+
+        bool ok() const { return m_ok; }
+
+        std::string_view take(std::size_t n) {
+          if (n > m_data.size()) {
+            m_ok = false;
+            return {};
+          }
+          std::string_view s = m_data.substr(0, n);
+          m_data.remove_prefix(n);
+          return s;
+        }
+
+        uint64_t get(int bytes) {
+          std::string_view s = take(bytes);
+          uint64_t value = 0;
+          for (std::size_t i = 0; i < s.size(); i++) {
+            value |= uint64_t{static_cast<uint8_t>(s[i])} << (i * 8);
+          }
+          return value;
+        }
+
+        void get_counts(rules::counts& c) {
+          std::string_view s = take(rule_bytes);
+          for (std::size_t i = 0; i < s.size() * 8 && i < c.size(); i++) {
+            c[i] = (static_cast<uint8_t>(s[i / 8]) >> (i % 8)) & 1;
+          }
+        }
+    };
+
+    inline int bits_per_cell(int states) {
+      return std::bit_width(static_cast<unsigned>(states - 1));
+    }
+
+    // PackBits: a control byte n < 128 is followed by n + 1 literal bytes,
+    // n >= 128 by one byte repeated n - 125 times.
+    inline void compress(const std::vector<uint8_t>& in, std::vector<uint8_t>& out) {
+      std::size_t i = 0;
+      while (i < in.size()) {
+        std::size_t run = 1;
+        while (i + run < in.size() && run < 130 && in[i + run] == in[i]) {
+          run++;
+        }
+
+        if (run >= 3) {
+          out.push_back(static_cast<uint8_t>(run + 125));
+          out.push_back(in[i]);
+          i += run;
+          continue;
+        }
+
+        // Literals, up to the next run of three
+        std::size_t start = i;
+        while (i < in.size() && i - start < 128) {
+          if (i + 2 < in.size() && in[i] == in[i + 1] && in[i] == in[i + 2]) {
+            break;
+          }
+          i++;
+        }
+        out.push_back(static_cast<uint8_t>(i - start - 1));
+        out.insert(out.end(), in.begin() + start, in.begin() + i);
+      }
+    }
+
+  }
+
+
+  inline std::vector<uint8_t> encode(const state& s) {
+    int bits = detail::bits_per_cell(s.rule.states);
+
+    std::vector<uint8_t> packed(((s.cells.size() * bits) + 7) / 8);
+    std::size_t bit = 0;
+    for (uint8_t c : s.cells) {
+      for (int b = 0; b < bits; b++, bit++) {
+        packed[bit / 8] |= ((c >> b) & 1) << (bit % 8);
+      }
+    }
+
+    std::vector<uint8_t> out(magic.begin(), magic.end());
+    detail::put(out, s.size.x, 4);
+    detail::put(out, s.size.y, 4);
+    detail::put(out, s.wrap, 1);
+    detail::put(out, s.rule.radius, 1);
+    detail::put(out, s.rule.states, 1);
+    detail::put(out, s.rule.include_centre, 1);
+    detail::put_counts(out, s.rule.birth);
+    detail::put_counts(out, s.rule.survive);
+    detail::put(out, s.number, 8);
+    detail::put(out, static_cast<uint32_t>(s.stats.alive), 4);
+    detail::put(out, static_cast<uint32_t>(s.stats.dead), 4);
+    detail::put(out, static_cast<uint32_t>(s.stats.alive_delta), 4);
+    detail::put(out, static_cast<uint32_t>(s.stats.dead_delta), 4);
+
+    std::size_t length_at = out.size();
+    detail::put(out, 0, 8);
+    detail::compress(packed, out);
+
+    uint64_t length = out.size() - length_at - 8;
+    for (int i = 0; i < 8; i++) {
+      out[length_at + i] = static_cast<uint8_t>(length >> (i * 8));
+    }
+    return out;
+  }
+
+
+  // Unpacks a checkpoint; nullopt if data is not a complete, valid one.
+  inline std::optional<state> decode(std::string_view data) {
+    detail::reader r(data);
+    if (r.take(magic.size()) != magic) {
+      return std::nullopt;
+    }
+
+    state s;
+    s.size.x = static_cast<int>(r.get(4));
+    s.size.y = static_cast<int>(r.get(4));
+    s.wrap = r.get(1);
+    s.rule.radius = static_cast<int>(r.get(1));
+    s.rule.states = static_cast<int>(r.get(1));
+    s.rule.include_centre = r.get(1);
+    r.get_counts(s.rule.birth);
+    r.get_counts(s.rule.survive);
+    s.number = r.get(8);
+    s.stats.alive = static_cast<int32_t>(r.get(4));
+    s.stats.dead = static_cast<int32_t>(r.get(4));
+    s.stats.alive_delta = static_cast<int32_t>(r.get(4));
+    s.stats.dead_delta = static_cast<int32_t>(r.get(4));
+    std::string_view payload = r.take(r.get(8));
+
+    if (!r.ok() || s.size.x <= 0 || s.size.y <= 0
+        || s.rule.radius < 1 || s.rule.radius > rules::max_radius || s.rule.states < 2) {
+      return std::nullopt;
+    }
+
+    // A run expands two bytes to at most 130, so a header claiming more
+    // cells than the payload could hold is rejected before allocating.
+    int bits = detail::bits_per_cell(s.rule.states);
+    std::size_t n = static_cast<std::size_t>(s.size.x) * s.size.y;
+    if (n > (payload.size() * 130 * 8) / bits) {
+      return std::nullopt;
+    }
+    s.cells.assign(n, 0);
+
+    // Decompress and unpack in one pass, straight into the cells.
+    std::size_t bit = 0, total = n * bits;
+    auto unpack = [&](uint8_t byte) {
+      for (int i = 0; i < 8 && bit < total; i++, bit++) {
+        s.cells[bit / bits] |= ((byte >> i) & 1) << (bit % bits);
+      }
+    };
+
+    const auto* p = reinterpret_cast<const uint8_t*>(payload.data());
+    const auto* end = p + payload.size();
+    while (p < end) {
+      uint8_t control = *p++;
+      if (control < 128) {
+        std::size_t count = control + 1u;
+        if (static_cast<std::size_t>(end - p) < count) {
+          return std::nullopt;
+        }
+        for (std::size_t i = 0; i < count; i++) {
+          unpack(*p++);
+        }
+      }
+      else {
+        if (p == end) {
+          return std::nullopt;
+        }
+        uint8_t byte = *p++;
+        for (int i = 0; i < control - 125; i++) {
+          unpack(byte);
+        }
+      }
+    }
+
+    if (bit != total) {
+      return std::nullopt;
+    }
+    for (uint8_t c : s.cells) {
+      if (c >= s.rule.states) {
+        return std::nullopt;
+      }
+    }
+    return s;
+  }
+
+
+  // Atomically replaces path with data. Throws std::runtime_error.
+  inline void write(const std::string& path, const std::vector<uint8_t>& data) {
+    std::string temporary = path + ".tmp";
+
+    std::FILE* f = std::fopen(temporary.c_str(), "wb");
+    if (!f) {
+      throw std::runtime_error("Failed to create checkpoint: " + temporary);
+    }
+    bool written = std::fwrite(data.data(), 1, data.size(), f) == data.size();
+    written = written && std::fflush(f) == 0 && ::fsync(::fileno(f)) == 0;
+    written = (std::fclose(f) == 0) && written;
+
+    if (!written || std::rename(temporary.c_str(), path.c_str()) != 0) {
+      std::remove(temporary.c_str());
+      throw std::runtime_error("Failed to write checkpoint: " + path);
+    }
+
+    // Makes the rename itself durable.
+    auto slash = path.rfind('/');
+    std::string directory = (slash == std::string::npos) ? "." : path.substr(0, slash + 1);
+    int fd = ::open(directory.c_str(), O_RDONLY | O_DIRECTORY);
+    if (fd >= 0) {
+      ::fsync(fd);
+      ::close(fd);
+    }
+  }
+
+
+  // nullopt if there is no usable checkpoint at path.
+  inline std::optional<state> read(const std::string& path) {
+    struct stat st{};
+    if (::stat(path.c_str(), &st) != 0 || st.st_size == 0) {
+      return std::nullopt;
+    }
+
+    try {
+      patterns::mapped_file file(path);
+      return decode(file.text());
+    }
+    catch (std::runtime_error const&) {
+      return std::nullopt; // Unreadable
+    }
+  }
+
+
+  // False, leaving the board alone, if the checkpoint is for another size.
+  inline bool restore(gameoflife& game, const state& s) {
+    if (!(s.size == game.size())) {
+      return false;
+    }
+    game.rule(s.rule);
+    game.wrap(s.wrap);
+    game.cells(s.cells.data());
+    game.statistics(s.stats);
+    return true;
+  }
+
+
+}
@@ -0,0 +1,624 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <optional>
+#include <random>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "random.h"
+#include "rules.h"
+
+
+// Conway's Game of Life engine, free of SDL so it can run headless.
+//
+// The board is a w*h array of 0/1 bytes, double buffered. Two engine modes
+// produce identical boards:
+//
+//   SCALAR evaluates every cell every generation.
+//   TILED  splits the board into tiles and only evaluates tiles that
+//          changed in the previous generation, plus their neighbours.
+//          Still lifes and empty space cost nothing.
+//
+// Every update() also lists the cells that flipped, so consumers can
+// follow the board incrementally instead of rescanning it.
+//
+// The rule defaults to Conway's B3/S23 and can be any rule from rules.h.
+// Cells hold their state: 0 dead, 1 alive, 2+ dying (Generations rules).
+//
+// The board is hashed Zobrist style: every (cell, state) has a fixed
+// random key and the hash is the XOR of the keys of all non-dead cells,
+// so a generation updates it with two XORs per changed cell. A small
+// direct-mapped table of recent hashes then spots a board that recurs,
+// static or periodic, in O(1) per generation.
+class gameoflife {
+public:
+    struct vector {
+      int x = 0;
+      int y = 0;
+
+      bool operator==(const vector&) const = default;
+    };
+
+    struct generation {
+        int alive = 0;
+        int dead = 0;
+        int alive_delta = 0;
+        int dead_delta = 0;
+        int active_tiles = 0; // Tiles evaluated this generation; 0 in SCALAR mode
+        uint64_t hash = 0;
+        int period = 0;       // Generations since this board was last seen, 0 if not recently
+    };
+
+    enum engine_mode { SCALAR, TILED };
+
+    // Rules with a kernel compiled in; any other rule uses a runtime table.
+    using specialised_rules = std::tuple<
+        rules::conway,
+        rules::highlife,
+        rules::seeds,
+        rules::day_and_night,
+        rules::brians_brain,
+        rules::star_wars,
+        rules::bosco
+    >;
+
+    static constexpr int tile_size = 32;
+
+    static constexpr int history_size = 256; // Direct-mapped slots; a power of two
+    static constexpr int max_period = 64;    // Longest cycle that is reported
+
+private:
+    vector m_grid_size;
+    std::vector<uint8_t> m_update;
+    std::vector<uint8_t> m_display;
+    std::vector<uint8_t> m_zero_row;
+    std::vector<uint32_t> m_flipped;
+    bool m_record_flips{true};
+    bool m_grid_wrap{true};
+    generation m_previous_generation;
+    engine_mode m_engine{TILED};
+
+    using span_kernel = int (gameoflife::*)(int, int, int);
+    rules::rule m_rule{rules::conway::describe()};
+    span_kernel m_span{&gameoflife::span<rules::conway>};
+    std::optional<rules::runtime> m_runtime;
+    std::vector<int> m_column_sums;
+
+    vector m_tiles;
+    std::vector<uint8_t> m_tile_changed; // Changed in the last generation
+    std::vector<uint8_t> m_tile_active;  // To be evaluated this generation
+    std::vector<int> m_tile_alive;
+
+    struct seen {
+      uint64_t hash = 0;
+      uint64_t number = 0; // 0 for an empty slot
+    };
+
+    uint64_t m_seed{(uint64_t{std::random_device{}()} << 32) | std::random_device{}()};
+    uint64_t m_fills{0}; // Fills drawn from m_seed so far
+
+    bool m_detect_cycles{true};
+    uint64_t m_hash{0};
+    uint64_t m_number{0};
+    std::array<seen, history_size> m_history{};
+
+public:
+    gameoflife(vector gs)
+        : m_grid_size(gs)
+        , m_update(gs.x * gs.y)
+        , m_display(gs.x * gs.y)
+        , m_zero_row(gs.x)
+        , m_tiles{(gs.x + tile_size - 1) / tile_size, (gs.y + tile_size - 1) / tile_size}
+        , m_tile_changed(m_tiles.x * m_tiles.y)
+        , m_tile_active(m_tiles.x * m_tiles.y)
+        , m_tile_alive(m_tiles.x * m_tiles.y)
+    {
+      initialise(6);
+    }
+
+    int n_cells() const {
+      return m_grid_size.x * m_grid_size.y;
+    }
+
+    int n_tiles() const {
+      return m_tiles.x * m_tiles.y;
+    }
+
+    int n_alive_cells() const {
+      int alive = 0;
+      for (int i=0; i < n_cells(); i++) {
+        if (m_display[i]) {
+          alive++;
+        }
+      }
+      return alive;
+    }
+
+    engine_mode engine() const {
+      return m_engine;
+    }
+
+    void engine(engine_mode mode) {
+      m_engine = mode;
+      invalidate();
+    }
+
+    const rules::rule& rule() const {
+      return m_rule;
+    }
+
+    // Dispatches to the compiled kernel for r if there is one. Cells in
+    // states r does not have, such as dying cells under a rule with fewer
+    // states, die.
+    void rule(const rules::rule& r) {
+      m_rule = r;
+      if (select_specialised(r, static_cast<specialised_rules*>(nullptr))) {
+        m_runtime.reset();
+      }
+      else {
+        m_runtime.emplace(r);
+        m_span = &gameoflife::span_runtime;
+      }
+
+      for (auto& cell : m_display) {
+        if (cell >= r.states) {
+          cell = 0;
+        }
+      }
+      edited();
+    }
+
+    bool rule(std::string_view text) {
+      auto r = rules::rule::parse(text);
+      if (!r) {
+        return false;
+      }
+      rule(*r);
+      return true;
+    }
+
+    bool rule_specialised() const {
+      return !m_runtime;
+    }
+
+    // Random fills are repeatable: the same seed gives the same sequence
+    // of boards. The default seed is random.
+    void seed(uint64_t s) {
+      m_seed = s;
+      m_fills = 0;
+    }
+
+    uint64_t seed() const {
+      return m_seed;
+    }
+
+    // Each cell alive with probability density.
+    void randomise(double density) {
+      prng::fill(m_display.data(), m_grid_size.x, m_grid_size.y, density, next_fill_seed());
+      std::fill(m_update.begin(), m_update.end(), 0);
+      edited();
+    }
+
+    // Each dead cell comes alive with probability density.
+    void sprinkle(double density) {
+      prng::fill(m_display.data(), m_grid_size.x, m_grid_size.y, density, next_fill_seed(), prng::fill_mode::ADD);
+      edited();
+    }
+
+    // One cell in factor alive.
+    void initialise(const int factor) {
+      randomise(1.0 / factor);
+    }
+
+    void mutate(const int factor) {
+      sprinkle(1.0 / factor);
+    }
+
+    bool wrap() {
+      m_grid_wrap = !m_grid_wrap;
+      invalidate();
+      forget();
+      return m_grid_wrap;
+    }
+
+    void wrap(bool state) {
+      m_grid_wrap = state;
+      invalidate();
+      forget();
+    }
+
+    bool wrapping() const {
+      return m_grid_wrap;
+    }
+
+    int xytoi(const vector c) const {
+      return (c.y * m_grid_size.x) + c.x;
+    }
+
+    vector size() const {
+      return m_grid_size;
+    }
+
+    bool cell_state(const vector c) const {
+      return m_display[xytoi(c)];
+    }
+
+    void cell_state(const vector c, bool alive) {
+      m_display[xytoi(c)] = alive;
+      edited();
+    }
+
+    void clear() {
+      std::fill(m_display.begin(), m_display.end(), 0);
+      std::fill(m_update.begin(), m_update.end(), 0);
+      edited();
+    }
+
+    // Sets length cells from c rightwards to state, clipped to the board.
+    // Only the tiles the run touches are marked for re-evaluation, so
+    // pattern loaders can write millions of runs cheaply.
+    void cell_run(vector c, int length, uint8_t state) {
+      if (c.y < 0 || c.y >= m_grid_size.y) {
+        return;
+      }
+      int x0 = std::max(c.x, 0);
+      int x1 = std::min(c.x + length, m_grid_size.x);
+      if (x0 >= x1) {
+        return;
+      }
+
+      uint32_t base = c.y * m_grid_size.x;
+      for (int x = x0; x < x1; x++) {
+        m_hash ^= zobrist(base + x, m_display[base + x]) ^ zobrist(base + x, state);
+      }
+      std::fill(m_display.begin() + base + x0, m_display.begin() + base + x1, state);
+
+      int ty = c.y / tile_size;
+      for (int tx = x0 / tile_size; tx <= (x1 - 1) / tile_size; tx++) {
+        m_tile_changed[(ty * m_tiles.x) + tx] = 1;
+      }
+    }
+
+    const uint8_t* cells() const {
+      return m_display.data();
+    }
+
+    // Replaces the whole board with n_cells() states.
+    void cells(const uint8_t* states) {
+      std::copy(states, states + n_cells(), m_display.begin());
+      edited();
+    }
+
+    // Statistics of the last generation, which the next one's deltas are
+    // taken against.
+    const generation& statistics() const {
+      return m_previous_generation;
+    }
+
+    void statistics(const generation& gen) {
+      m_previous_generation = gen;
+    }
+
+    uint64_t hash() const {
+      return m_hash;
+    }
+
+    // Hashing costs a little per changed cell; without it generation
+    // hash and period are always 0.
+    void detect_cycles(bool state) {
+      m_detect_cycles = state;
+      edited();
+    }
+
+    // Indices of the cells that flipped in the last update(). Direct
+    // edits (initialise, mutate, cell_state) are not listed.
+    const std::vector<uint32_t>& flipped() const {
+      return m_flipped;
+    }
+
+    void record_flips(bool state) {
+      m_record_flips = state;
+      m_flipped.clear();
+    }
+
+    // Everything must be re-evaluated after the board is edited directly.
+    void invalidate() {
+      std::fill(m_tile_changed.begin(), m_tile_changed.end(), 1);
+    }
+
+    generation update() {
+      m_flipped.clear();
+
+      generation gen = (m_engine == TILED)
+                     ? update_tiled()
+                     : update_scalar();
+
+      m_display.swap(m_update);
+
+      gen.dead = n_cells() - gen.alive;
+      gen.alive_delta = m_previous_generation.alive - gen.alive;
+      gen.dead_delta  = m_previous_generation.dead  - gen.dead;
+      if (m_detect_cycles) {
+        gen.hash = m_hash;
+        gen.period = recurrence();
+      }
+
+      m_previous_generation = gen;
+      return gen;
+    }
+
+protected:
+    // Odd per-cell key, times the state; dead cells contribute nothing.
+    static uint64_t zobrist(uint32_t i) {
+      uint64_t z = (uint64_t{i} + 1) * 0x9e3779b97f4a7c15; // splitmix64 finaliser
+      z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9;
+      z = (z ^ (z >> 27)) * 0x94d049bb133111eb;
+      return (z ^ (z >> 31)) | 1;
+    }
+
+    static uint64_t zobrist(uint32_t i, uint8_t state) {
+      return zobrist(i) * state;
+    }
+
+    uint64_t next_fill_seed() {
+      uint64_t s = m_seed + m_fills++;
+      return prng::splitmix64(s);
+    }
+
+    // After the board is changed other than by update().
+    void edited() {
+      invalidate();
+      m_hash = 0;
+      for (int i = 0; i < n_cells(); i++) {
+        m_hash ^= zobrist(i, m_display[i]);
+      }
+      forget();
+    }
+
+    // Earlier boards say nothing about the future once the rules change.
+    void forget() {
+      m_history.fill(seen{});
+    }
+
+    // Records the current board; returns how many generations ago it was
+    // last seen, if within max_period.
+    int recurrence() {
+      m_number++;
+      seen& slot = m_history[m_hash & (history_size - 1)];
+
+      int period = 0;
+      if (slot.number && slot.hash == m_hash && m_number - slot.number <= max_period) {
+        period = static_cast<int>(m_number - slot.number);
+      }
+
+      slot = {m_hash, m_number};
+      return period;
+    }
+
+    generation update_scalar() {
+      generation gen;
+      for (int cy = 0; cy < m_grid_size.y; cy++) {
+        gen.alive += (this->*m_span)(cy, 0, m_grid_size.x);
+      }
+      invalidate(); // Tile state is unknown to the next TILED generation
+      return gen;
+    }
+
+    generation update_tiled() {
+      generation gen;
+      mark_active_tiles();
+
+      for (int ty = 0; ty < m_tiles.y; ty++) {
+        for (int tx = 0; tx < m_tiles.x; tx++) {
+          int t = (ty * m_tiles.x) + tx;
+          if (!m_tile_active[t]) {
+            // Unchanged last generation, so both buffers already agree.
+            m_tile_changed[t] = 0;
+            gen.alive += m_tile_alive[t];
+            continue;
+          }
+
+          int x0 = tx * tile_size, x1 = std::min(x0 + tile_size, m_grid_size.x);
+          int y0 = ty * tile_size, y1 = std::min(y0 + tile_size, m_grid_size.y);
+
+          int alive = 0;
+          bool changed = false;
+          for (int cy = y0; cy < y1; cy++) {
+            alive += (this->*m_span)(cy, x0, x1);
+            changed = changed || !std::equal(
+                m_update.begin() + xytoi({x0, cy}), m_update.begin() + xytoi({x1, cy}),
+                m_display.begin() + xytoi({x0, cy})
+            );
+          }
+
+          m_tile_alive[t] = alive;
+          m_tile_changed[t] = changed;
+          gen.alive += alive;
+          gen.active_tiles++;
+        }
+      }
+
+      return gen;
+    }
+
+    // A tile is evaluated if it, or any tile touching it, changed.
+    void mark_active_tiles() {
+      std::fill(m_tile_active.begin(), m_tile_active.end(), 0);
+
+      for (int ty = 0; ty < m_tiles.y; ty++) {
+        for (int tx = 0; tx < m_tiles.x; tx++) {
+          if (!m_tile_changed[(ty * m_tiles.x) + tx]) {
+            continue;
+          }
+
+          for (int dy = -1; dy <= 1; dy++) {
+            for (int dx = -1; dx <= 1; dx++) {
+              int nx = tx + dx, ny = ty + dy;
+              if (m_grid_wrap) {
+                nx = (nx + m_tiles.x) % m_tiles.x;
+                ny = (ny + m_tiles.y) % m_tiles.y;
+              }
+              else if (nx < 0 || ny < 0 || nx >= m_tiles.x || ny >= m_tiles.y) {
+                continue;
+              }
+              m_tile_active[(ny * m_tiles.x) + nx] = 1;
+            }
+          }
+        }
+      }
+    }
+
+    const uint8_t* row(int cy) const {
+      if (cy < 0 || cy >= m_grid_size.y) {
+        if (!m_grid_wrap) {
+          return m_zero_row.data();
+        }
+        cy = ((cy % m_grid_size.y) + m_grid_size.y) % m_grid_size.y;
+      }
+      return m_display.data() + (cy * m_grid_size.x);
+    }
+
+    int column(int cx) const {
+      if (cx < 0 || cx >= m_grid_size.x) {
+        return m_grid_wrap ? ((cx % m_grid_size.x) + m_grid_size.x) % m_grid_size.x : -1;
+      }
+      return cx;
+    }
+
+    template <typename K>
+    int span(int cy, int x0, int x1) {
+      return evaluate_span(K{}, cy, x0, x1);
+    }
+
+    int span_runtime(int cy, int x0, int x1) {
+      return evaluate_span(*m_runtime, cy, x0, x1);
+    }
+
+    template <typename... K>
+    bool select_specialised(const rules::rule& r, std::tuple<K...>*) {
+      return ((K::describe() == r && (m_span = &gameoflife::span<K>, true)) || ...);
+    }
+
+    // Unrolled at compile time for kernels with a constexpr radius.
+    template <std::size_t... K>
+    static int column_sum(const uint8_t* const* lines, int cx, std::index_sequence<K...>) {
+      return ((lines[K][cx] == 1) + ...);
+    }
+
+    // Writes the next state of cells [x0, x1) on row cy; returns how many live.
+    //
+    // Live cells are summed down each column of the neighbourhood first,
+    // then a window of 2R+1 column sums slides along the row.
+    template <typename K>
+    int evaluate_span(const K& kernel, int cy, int x0, int x1) {
+      const int r = kernel.radius;
+      const int w = m_grid_size.x;
+      const int first = x0 - r;
+      const int span = (x1 - x0) + (2 * r);
+
+      m_column_sums.resize(span);
+      int* sums = m_column_sums.data();
+
+      const int height = (2 * r) + 1;
+      const uint8_t* lines[(2 * rules::max_radius) + 1];
+      for (int k = 0; k < height; k++) {
+        lines[k] = row(cy - r + k);
+      }
+
+      // Columns that need no wrapping are summed without bounds checks.
+      const int inner_begin = std::clamp(-first, 0, span);
+      const int inner_end = std::clamp(w - first, inner_begin, span);
+
+      auto edge_sum = [&](int j) {
+        int cx = column(first + j);
+        int sum = 0;
+        for (int k = 0; cx >= 0 && k < height; k++) {
+          sum += (lines[k][cx] == 1);
+        }
+        return sum;
+      };
+
+      for (int j = 0; j < inner_begin; j++) {
+        sums[j] = edge_sum(j);
+      }
+
+      if constexpr (!std::is_same_v<K, rules::runtime>) {
+        constexpr auto rows = std::make_index_sequence<(2 * K::radius) + 1>{};
+        for (int j = inner_begin; j < inner_end; j++) {
+          sums[j] = column_sum(lines, first + j, rows);
+        }
+      }
+      else {
+        for (int j = inner_begin; j < inner_end; j++) {
+          int sum = 0;
+          for (int k = 0; k < height; k++) {
+            sum += (lines[k][first + j] == 1);
+          }
+          sums[j] = sum;
+        }
+      }
+
+      for (int j = inner_end; j < span; j++) {
+        sums[j] = edge_sum(j);
+      }
+
+      const uint8_t* centre = row(cy);
+      uint8_t* out = m_update.data() + (cy * w);
+      uint32_t base = cy * w;
+
+      int window = 0;
+      for (int j = 0; j < 2 * r; j++) {
+        window += sums[j];
+      }
+
+      // Locals, since stores through out could alias the members.
+      const bool flips = m_record_flips;
+      const bool cycles = m_detect_cycles;
+      uint64_t hash = m_hash;
+
+      // Instantiated twice so the plain loop carries no change tracking.
+      int alive = 0;
+      auto evaluate = [&](auto track) {
+        for (int cx = x0; cx < x1; cx++) {
+          int j = cx - x0;
+          window += sums[j + (2 * r)];
+
+          uint8_t state = centre[cx];
+          int count = kernel.include_centre ? window : window - (state == 1);
+          uint8_t next = kernel.next(state, count);
+          out[cx] = next;
+          alive += (next == 1);
+
+          if constexpr (decltype(track)::value) {
+            if (next != state) {
+              if (cycles) {
+                uint64_t key = zobrist(base + cx);
+                hash ^= (key * state) ^ (key * next);
+              }
+              if (flips) {
+                m_flipped.push_back(base + cx);
+              }
+            }
+          }
+
+          window -= sums[j];
+        }
+      };
+
+      if (flips || cycles) {
+        evaluate(std::true_type{});
+      }
+      else {
+        evaluate(std::false_type{});
+      }
+
+      m_hash = hash;
+      return alive;
+    }
+};
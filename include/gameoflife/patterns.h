@@ -0,0 +1,456 @@
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <charconv>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "gameoflife.h"
+
+
+// Loaders for RLE (.rle) and Macrocell (.mc) pattern files.
+//
+// Files are memory mapped and parsed in place: cell data is never copied
+// into intermediate strings. RLE bodies are streamed straight onto the
+// board as runs of cells. Macrocell files are read into their own
+// quadtree of nodes, and the board is filled by walking that tree,
+// skipping empty nodes and anything that falls outside the board, so a
+// pattern far bigger than the board still loads quickly.
+namespace patterns {
+
+
+  class mapped_file {
+    protected:
+      std::string m_path;
+      void* m_data{MAP_FAILED};
+      std::size_t m_size{0};
+
+    public:
+      explicit mapped_file(std::string path)
+        : m_path{std::move(path)}
+      {
+        int fd = ::open(m_path.c_str(), O_RDONLY);
+        if (fd < 0) {
+          throw std::runtime_error("Failed to open pattern file: " + m_path);
+        }
+
+        struct stat st{};
+        if (::fstat(fd, &st) == 0 && st.st_size > 0) {
+          m_size = st.st_size;
+          m_data = ::mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        }
+        ::close(fd);
+
+        if (m_data == MAP_FAILED) {
+          throw std::runtime_error("Failed to map pattern file: " + m_path);
+        }
+        ::madvise(m_data, m_size, MADV_SEQUENTIAL);
+      }
+
+      mapped_file(const mapped_file&) = delete;
+      mapped_file& operator=(const mapped_file&) = delete;
+
+      ~mapped_file() {
+        ::munmap(m_data, m_size);
+      }
+
+      const std::string& path() const { return m_path; }
+
+      std::string_view text() const {
+        return {static_cast<const char*>(m_data), m_size};
+      }
+  };
+
+
+  // Far beyond any board; larger sizes and runs in RLE files are rejected
+  // or saturated.
+  constexpr int64_t max_run = int64_t{1} << 32;
+
+
+  struct header {
+    int64_t width = 0;
+    int64_t height = 0;
+    int64_t generation = 0;
+    std::string rule; // Empty if the file does not name one
+  };
+
+
+  namespace detail {
+
+    inline bool is_space(char c) {
+      return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+    }
+
+    inline std::string_view trim(std::string_view s) {
+      while (!s.empty() && is_space(s.front())) s.remove_prefix(1);
+      while (!s.empty() && is_space(s.back())) s.remove_suffix(1);
+      return s;
+    }
+
+    // Splits off the next line, without its terminator.
+    inline std::string_view next_line(std::string_view& text) {
+      auto end = text.find('\n');
+      std::string_view line = text.substr(0, end);
+      text = (end == std::string_view::npos) ? std::string_view{} : text.substr(end + 1);
+      if (!line.empty() && line.back() == '\r') {
+        line.remove_suffix(1);
+      }
+      return line;
+    }
+
+    template <typename T>
+    bool parse_number(std::string_view& s, T& out) {
+      s = trim(s);
+      auto [ptr, ec] = std::from_chars(s.data(), s.data() + s.size(), out);
+      if (ec != std::errc{}) {
+        return false;
+      }
+      s.remove_prefix(ptr - s.data());
+      return true;
+    }
+
+  }
+
+
+  // Reads the comments and "x = m, y = n, rule = ..." line of an RLE
+  // file, leaving text at the start of the body.
+  inline header rle_header(std::string_view& text) {
+    header h;
+
+    while (!text.empty()) {
+      std::string_view rest = text;
+      std::string_view line = detail::trim(detail::next_line(rest));
+
+      if (line.empty() || line[0] == '#') {
+        if (line.substr(0, 2) == "#r" && h.rule.empty()) {
+          h.rule = detail::trim(line.substr(2));
+        }
+        text = rest;
+        continue;
+      }
+
+      if (line[0] != 'x') {
+        break; // No header; the body starts here
+      }
+
+      while (!line.empty()) {
+        auto comma = line.find(',');
+        std::string_view field = line.substr(0, comma);
+        line = (comma == std::string_view::npos) ? std::string_view{} : line.substr(comma + 1);
+
+        auto equals = field.find('=');
+        if (equals == std::string_view::npos) {
+          throw std::runtime_error("Malformed RLE header");
+        }
+        std::string_view key = detail::trim(field.substr(0, equals));
+        std::string_view value = detail::trim(field.substr(equals + 1));
+
+        if (key == "x" || key == "y") {
+          int64_t n = 0;
+          if (!detail::parse_number(value, n) || n < 0 || n > max_run) {
+            throw std::runtime_error("Malformed RLE size");
+          }
+          (key == "x" ? h.width : h.height) = n;
+        }
+        else if (key == "rule") {
+          h.rule = value.substr(0, value.find(':')); // Drop any bounded grid suffix
+        }
+      }
+      text = rest;
+      break;
+    }
+
+    return h;
+  }
+
+
+  // Streams an RLE body as runs of live cells, calling
+  // emit(x, y, length, state) with coordinates relative to the pattern's
+  // top left. Dead runs just move the cursor. Multi-state files use '.'
+  // for dead, 'A'..'X' for states 1-24 and 'p'..'y' prefixes above that.
+  // Run counts and the cursor saturate at max_run, so no file can
+  // overflow them.
+  template <typename Emit>
+  void rle_body(std::string_view text, Emit&& emit) {
+    const char* p = text.data();
+    const char* end = p + text.size();
+
+    int64_t x = 0, y = 0;
+    int64_t count = 0;
+    int prefix = 0;
+
+    while (p < end) {
+      char c = *p++;
+
+      if (c >= '0' && c <= '9') {
+        count = std::min((count * 10) + (c - '0'), max_run);
+        continue;
+      }
+
+      int64_t n = count ? count : 1;
+      count = 0;
+
+      if (c == '!') {
+        return;
+      }
+      if (c == '#') { // Comment in the body, e.g. trailing #C lines
+        while (p < end && *p != '\n') p++;
+        continue;
+      }
+      if (detail::is_space(c)) {
+        continue;
+      }
+
+      int state;
+      if (c == 'b' || c == '.') {
+        state = 0;
+      }
+      else if (c == '$') {
+        x = 0;
+        y = std::min(y + n, max_run);
+        continue;
+      }
+      else if (c >= 'p' && c <= 'y' && p < end && *p >= 'A' && *p <= 'X') {
+        prefix = 24 * (c - 'p' + 1);
+        count = n == 1 ? 0 : n; // The count belongs to the state that follows
+        continue;
+      }
+      else if (c >= 'A' && c <= 'X') {
+        state = prefix + (c - 'A' + 1);
+      }
+      else {
+        state = 1; // 'o', and any other letter in two-state files
+      }
+      prefix = 0;
+
+      if (state) {
+        emit(x, y, n, static_cast<uint8_t>(state > 255 ? 255 : state));
+      }
+      x = std::min(x + n, max_run);
+    }
+  }
+
+
+  // A Macrocell pattern, kept as the file's own hash-consed quadtree.
+  //
+  // Node 0 is the empty node. Two-state files have 8x8 leaves at level 3;
+  // multi-state files have level 1 nodes whose children are cell states.
+  class quadtree {
+    public:
+      struct node {
+        uint8_t level = 0;
+        uint32_t child[4] = {0, 0, 0, 0}; // nw, ne, sw, se; states at level 1
+        uint64_t bits = 0;                // 8x8 leaves, bit (y * 8) + x
+        bool leaf = false;
+      };
+
+    protected:
+      std::vector<node> m_nodes{node{}};
+
+    public:
+      static constexpr int max_level = 62;
+
+      const std::vector<node>& nodes() const {
+        return m_nodes;
+      }
+
+      uint32_t root() const {
+        return static_cast<uint32_t>(m_nodes.size() - 1);
+      }
+
+      int level() const {
+        return m_nodes.back().level;
+      }
+
+      void add(node n) {
+        m_nodes.push_back(n);
+      }
+
+      // Calls emit(x, y, length, state) for every run of live cells in a
+      // node that overlaps [0, clip), with the tree's top left at (ox, oy).
+      template <typename Emit>
+      void runs(int64_t ox, int64_t oy, int64_t clip_x, int64_t clip_y, Emit&& emit) const {
+        walk(root(), ox, oy, clip_x, clip_y, emit);
+      }
+
+    protected:
+      template <typename Emit>
+      void walk(uint32_t index, int64_t x, int64_t y, int64_t clip_x, int64_t clip_y, Emit& emit) const {
+        if (index == 0) {
+          return;
+        }
+
+        const node& n = m_nodes[index];
+        int64_t size = int64_t{1} << n.level;
+        if (x >= clip_x || y >= clip_y || x + size <= 0 || y + size <= 0) {
+          return;
+        }
+
+        if (n.leaf) {
+          for (int row = 0; row < 8; row++) {
+            uint32_t bits = (n.bits >> (row * 8)) & 0xff;
+            while (bits) {
+              int start = std::countr_zero(bits);
+              int length = std::countr_one(bits >> start);
+              emit(x + start, y + row, int64_t{length}, uint8_t{1});
+              bits &= ~(((1u << length) - 1) << start);
+            }
+          }
+          return;
+        }
+
+        if (n.level == 1) {
+          for (int q = 0; q < 4; q++) {
+            if (n.child[q]) {
+              emit(x + (q & 1), y + (q >> 1), int64_t{1}, static_cast<uint8_t>(n.child[q]));
+            }
+          }
+          return;
+        }
+
+        int64_t half = size / 2;
+        walk(n.child[0], x,        y,        clip_x, clip_y, emit);
+        walk(n.child[1], x + half, y,        clip_x, clip_y, emit);
+        walk(n.child[2], x,        y + half, clip_x, clip_y, emit);
+        walk(n.child[3], x + half, y + half, clip_x, clip_y, emit);
+      }
+  };
+
+
+  inline bool is_macrocell(std::string_view text) {
+    return text.substr(0, 4) == "[M2]";
+  }
+
+
+  inline quadtree read_macrocell(std::string_view text, header& h) {
+    quadtree tree;
+    detail::next_line(text); // [M2] (program version)
+
+    while (!text.empty()) {
+      std::string_view line = detail::next_line(text);
+      if (line.empty()) {
+        continue;
+      }
+
+      if (line[0] == '#') {
+        if (line.size() > 1 && line[1] == 'R') {
+          h.rule = detail::trim(line.substr(2));
+        }
+        else if (line.size() > 1 && line[1] == 'G') {
+          std::string_view g = line.substr(2);
+          detail::parse_number(g, h.generation);
+        }
+        continue;
+      }
+
+      quadtree::node n;
+
+      if (line[0] == '.' || line[0] == '*' || line[0] == '$') {
+        n.level = 3;
+        n.leaf = true;
+        int x = 0, y = 0;
+        for (char c : line) {
+          if (c == '$') {
+            x = 0;
+            y++;
+          }
+          else if (x < 8 && y < 8) {
+            if (c == '*') {
+              n.bits |= uint64_t{1} << ((y * 8) + x);
+            }
+            x++;
+          }
+        }
+      }
+      else {
+        int level = 0;
+        if (!detail::parse_number(line, level) || level < 1 || level > quadtree::max_level) {
+          throw std::runtime_error("Malformed Macrocell node");
+        }
+        n.level = static_cast<uint8_t>(level);
+        for (auto& c : n.child) {
+          if (!detail::parse_number(line, c)) {
+            throw std::runtime_error("Malformed Macrocell node");
+          }
+          if (level > 1 && (c >= tree.nodes().size() || (c && tree.nodes()[c].level != level - 1))) {
+            throw std::runtime_error("Macrocell node refers to an invalid child");
+          }
+        }
+      }
+
+      tree.add(n);
+    }
+
+    if (tree.root() == 0) {
+      throw std::runtime_error("Macrocell file has no nodes");
+    }
+
+    h.width = h.height = int64_t{1} << tree.level();
+    return tree;
+  }
+
+
+  // Replaces the board with the pattern in path, centred, and switches to
+  // the file's rule if it names one the engine understands. Throws
+  // std::runtime_error if the file cannot be read.
+  inline header load(gameoflife& game, const std::string& path) {
+    mapped_file file(path);
+    std::string_view text = file.text();
+
+    header h;
+    quadtree tree;
+    bool macrocell = is_macrocell(text);
+    if (macrocell) {
+      tree = read_macrocell(text, h);
+    }
+    else {
+      h = rle_header(text);
+    }
+
+    if (!h.rule.empty()) {
+      game.rule(h.rule);
+    }
+
+    game.clear();
+
+    auto board = game.size();
+    int64_t ox = (board.x - h.width) / 2;
+    int64_t oy = (board.y - h.height) / 2;
+    uint8_t top = static_cast<uint8_t>(game.rule().states - 1);
+
+    auto place = [&](int64_t x, int64_t y, int64_t length, uint8_t state) {
+      if (y < 0 || y >= board.y || x >= board.x || x + length <= 0) {
+        return;
+      }
+      int64_t x0 = std::max<int64_t>(x, 0);
+      int64_t x1 = std::min<int64_t>(x + length, board.x);
+      game.cell_run(
+          {static_cast<int>(x0), static_cast<int>(y)},
+          static_cast<int>(x1 - x0),
+          std::min(state, top)
+      );
+    };
+
+    if (macrocell) {
+      tree.runs(ox, oy, board.x, board.y, place);
+    }
+    else {
+      rle_body(text, [&](int64_t x, int64_t y, int64_t length, uint8_t state) {
+        place(x + ox, y + oy, length, state);
+      });
+    }
+
+    return h;
+  }
+
+
+}
@@ -0,0 +1,158 @@
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+
+// Seeded bulk random fills for boards.
+//
+// xoshiro256** produces 64 random bits per call. A word whose bits are
+// each set with probability p is built by walking the binary expansion
+// of p, combining one random word per digit, so 64 cells cost at most
+// `precision` generator calls instead of one rand() each.
+//
+// Boards are filled in fixed bands of rows, each from its own stream
+// seeded from (seed, band). Bands can run on any number of threads and
+// the board depends only on the seed.
+namespace prng {
+
+
+  inline uint64_t splitmix64(uint64_t& x) {
+    uint64_t z = (x += 0x9e3779b97f4a7c15);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111eb;
+    return z ^ (z >> 31);
+  }
+
+
+  // Satisfies UniformRandomBitGenerator, so it also works with <random>.
+  class xoshiro256 {
+    protected:
+      uint64_t m_s[4];
+
+    public:
+      using result_type = uint64_t;
+
+      explicit xoshiro256(uint64_t seed) {
+        for (auto& s : m_s) {
+          s = splitmix64(seed);
+        }
+      }
+
+      static constexpr result_type min() { return 0; }
+      static constexpr result_type max() { return ~result_type{0}; }
+
+      result_type operator()() {
+        const uint64_t result = std::rotl(m_s[1] * 5, 7) * 9;
+        const uint64_t t = m_s[1] << 17;
+
+        m_s[2] ^= m_s[0];
+        m_s[3] ^= m_s[1];
+        m_s[1] ^= m_s[2];
+        m_s[0] ^= m_s[3];
+        m_s[2] ^= t;
+        m_s[3] = std::rotl(m_s[3], 45);
+
+        return result;
+      }
+  };
+
+
+  // Bits of density kept; 1/65536 is the finest step.
+  constexpr int precision = 16;
+
+  inline uint32_t threshold(double density) {
+    double scaled = std::round(density * (1u << precision));
+    return static_cast<uint32_t>(std::clamp(scaled, 0.0, double{1u << precision}));
+  }
+
+  // 64 bits, each set with probability t / 2^precision.
+  inline uint64_t bernoulli(xoshiro256& g, uint32_t t) {
+    if (t == 0) {
+      return 0;
+    }
+    if (t >= (1u << precision)) {
+      return ~uint64_t{0};
+    }
+
+    // From the lowest set digit up: a 1 ORs in a fresh word, lifting the
+    // probability to (1 + p) / 2; a 0 ANDs one in, halving it.
+    int digit = std::countr_zero(t);
+    uint64_t w = g();
+    for (digit++; digit < precision; digit++) {
+      uint64_t r = g();
+      w = ((t >> digit) & 1) ? (w | r) : (w & r);
+    }
+    return w;
+  }
+
+
+  enum class fill_mode {
+    REPLACE, // Every cell becomes 0 or 1
+    ADD      // Only dead cells may come alive
+  };
+
+  constexpr int band_rows = 32;
+
+  inline void fill_band(uint8_t* cells, int width, int band, int height, uint32_t t, uint64_t seed, fill_mode mode) {
+    uint64_t stream = seed ^ (0xd1b54a32d192ed03 * static_cast<uint64_t>(band + 1));
+    xoshiro256 g(stream);
+
+    int y1 = std::min(height, (band + 1) * band_rows);
+    for (int y = band * band_rows; y < y1; y++) {
+      uint8_t* row = cells + (static_cast<std::size_t>(y) * width);
+
+      for (int x = 0; x < width; x += 64) {
+        uint64_t w = bernoulli(g, t);
+        int n = std::min(64, width - x);
+
+        if (mode == fill_mode::REPLACE) {
+          for (int b = 0; b < n; b++) {
+            row[x + b] = (w >> b) & 1;
+          }
+        }
+        else {
+          for (int b = 0; b < n; b++) {
+            uint8_t c = row[x + b];
+            row[x + b] = c ? c : static_cast<uint8_t>((w >> b) & 1);
+          }
+        }
+      }
+    }
+  }
+
+  // Threads defaults to the hardware's for boards of a million cells or
+  // more, otherwise one. The result does not depend on it.
+  inline void fill(uint8_t* cells, int width, int height, double density, uint64_t seed,
+                   fill_mode mode = fill_mode::REPLACE, unsigned threads = 0) {
+    uint32_t t = threshold(density);
+    int bands = (height + band_rows - 1) / band_rows;
+
+    if (threads == 0) {
+      bool large = static_cast<std::size_t>(width) * height >= (1u << 20);
+      threads = large ? std::max(1u, std::thread::hardware_concurrency()) : 1;
+    }
+    threads = std::min<unsigned>(threads, std::max(bands, 1));
+
+    auto work = [&](unsigned first) {
+      for (int band = first; band < bands; band += threads) {
+        fill_band(cells, width, band, height, t, seed, mode);
+      }
+    };
+
+    std::vector<std::thread> pool;
+    for (unsigned i = 1; i < threads; i++) {
+      pool.emplace_back(work, i);
+    }
+    work(0);
+    for (auto& thread : pool) {
+      thread.join();
+    }
+  }
+
+
+}
@@ -0,0 +1,327 @@
+#pragma once
+
+#include <array>
+#include <bitset>
+#include <charconv>
+#include <cstdint>
+#include <initializer_list>
+#include <optional>
+#include <string_view>
+#include <vector>
+
+
+// Life-like rules and the kernels that evaluate them.
+//
+// A rule is outer-totalistic: a cell's next state depends only on its own
+// state and how many live cells are in its neighbourhood. That covers
+// B/S rules (Conway's B3/S23 and friends), Generations rules where cells
+// decay through C-2 dying states before dying, and Larger-than-Life rules
+// with Moore neighbourhoods of radius R.
+//
+// Every kernel reduces to one table lookup, next = table[state][count],
+// so cell evaluation is branchless. Common rules are instantiated at
+// compile time with constexpr tables; anything else runs on a table built
+// at runtime.
+namespace rules {
+
+
+  constexpr int max_radius = 10;
+  constexpr int max_count = (2 * max_radius + 1) * (2 * max_radius + 1);
+
+  using counts = std::bitset<max_count + 1>;
+
+
+  // Runtime description, as parsed from a rule string.
+  struct rule {
+    int radius = 1;
+    int states = 2;              // 2 for plain Life-like rules
+    bool include_centre = false; // Whether a cell counts itself
+    counts birth;
+    counts survive;
+
+    int neighbourhood() const {
+      return (2 * radius + 1) * (2 * radius + 1);
+    }
+
+    bool operator==(const rule&) const = default;
+
+    // Accepts "B3/S23", "B2/S/C3" (or "B2/S/3") and Larger-than-Life
+    // "R5,C0,M1,S34..58,B34..45".
+    static std::optional<rule> parse(std::string_view text);
+  };
+
+
+  constexpr uint32_t mask(std::initializer_list<int> ns) {
+    uint32_t m = 0;
+    for (int n : ns) {
+      m |= uint32_t{1} << n;
+    }
+    return m;
+  }
+
+
+  // Next state for a cell in state s with n live neighbours.
+  constexpr uint8_t transition(uint8_t s, bool birth, bool survive, int states) {
+    if (s == 0) {
+      return birth ? 1 : 0;
+    }
+    if (s == 1) {
+      return survive ? 1 : (states > 2 ? 2 : 0);
+    }
+    return (s + 1 < states) ? s + 1 : 0; // Dying cells age regardless of neighbours
+  }
+
+
+  // B/S (and /C for Generations) over the 8-cell Moore neighbourhood.
+  template <uint32_t Birth, uint32_t Survive, int States = 2>
+  struct totalistic {
+    static constexpr int radius = 1;
+    static constexpr bool include_centre = false;
+    static constexpr int states = States;
+    static constexpr int stride = 9;
+
+    static constexpr std::array<uint8_t, States * stride> table = []() {
+      std::array<uint8_t, States * stride> t{};
+      for (int s = 0; s < States; s++) {
+        for (int n = 0; n < stride; n++) {
+          t[s * stride + n] = transition(s, (Birth >> n) & 1, (Survive >> n) & 1, States);
+        }
+      }
+      return t;
+    }();
+
+    uint8_t next(uint8_t state, int count) const {
+      return table[state * stride + count];
+    }
+
+    static rule describe() {
+      rule r;
+      r.states = States;
+      for (int n = 0; n < stride; n++) {
+        r.birth[n] = (Birth >> n) & 1;
+        r.survive[n] = (Survive >> n) & 1;
+      }
+      return r;
+    }
+  };
+
+
+  // Larger than Life: birth and survival are count ranges over a radius-R
+  // Moore neighbourhood, by convention including the cell itself.
+  template <int Radius, int States, int BirthLo, int BirthHi, int SurviveLo, int SurviveHi, bool IncludeCentre = true>
+  struct larger_than_life {
+    static_assert(Radius >= 1 && Radius <= max_radius);
+
+    static constexpr int radius = Radius;
+    static constexpr bool include_centre = IncludeCentre;
+    static constexpr int states = States;
+    static constexpr int stride = (2 * Radius + 1) * (2 * Radius + 1) + 1;
+
+    static constexpr std::array<uint8_t, States * stride> table = []() {
+      std::array<uint8_t, States * stride> t{};
+      for (int s = 0; s < States; s++) {
+        for (int n = 0; n < stride; n++) {
+          bool birth = BirthLo <= n && n <= BirthHi;
+          bool survive = SurviveLo <= n && n <= SurviveHi;
+          t[s * stride + n] = transition(s, birth, survive, States);
+        }
+      }
+      return t;
+    }();
+
+    uint8_t next(uint8_t state, int count) const {
+      return table[state * stride + count];
+    }
+
+    static rule describe() {
+      rule r;
+      r.radius = Radius;
+      r.states = States;
+      r.include_centre = IncludeCentre;
+      for (int n = 0; n < stride; n++) {
+        r.birth[n] = BirthLo <= n && n <= BirthHi;
+        r.survive[n] = SurviveLo <= n && n <= SurviveHi;
+      }
+      return r;
+    }
+  };
+
+
+  // Any rule, with its table built when selected.
+  struct runtime {
+    int radius;
+    bool include_centre;
+    int states;
+    int stride;
+    std::vector<uint8_t> table;
+
+    explicit runtime(const rule& r)
+      : radius{r.radius}
+      , include_centre{r.include_centre}
+      , states{r.states}
+      , stride{r.neighbourhood() + 1}
+      , table(r.states * stride)
+    {
+      for (int s = 0; s < states; s++) {
+        for (int n = 0; n < stride; n++) {
+          table[s * stride + n] = transition(s, r.birth[n], r.survive[n], states);
+        }
+      }
+    }
+
+    uint8_t next(uint8_t state, int count) const {
+      return table[state * stride + count];
+    }
+  };
+
+
+  using conway        = totalistic<mask({3}), mask({2, 3})>;
+  using highlife      = totalistic<mask({3, 6}), mask({2, 3})>;
+  using seeds         = totalistic<mask({2}), 0>;
+  using day_and_night = totalistic<mask({3, 6, 7, 8}), mask({3, 4, 6, 7, 8})>;
+  using brians_brain  = totalistic<mask({2}), 0, 3>;
+  using star_wars     = totalistic<mask({2}), mask({3, 4, 5}), 4>;
+  using bosco         = larger_than_life<5, 2, 34, 45, 34, 58>;
+
+
+  namespace detail {
+
+    inline bool parse_int(std::string_view& s, int& out) {
+      auto [ptr, ec] = std::from_chars(s.data(), s.data() + s.size(), out);
+      if (ec != std::errc{}) {
+        return false;
+      }
+      s.remove_prefix(ptr - s.data());
+      return true;
+    }
+
+    inline bool parse_digits(std::string_view s, counts& out) {
+      for (char c : s) {
+        if (c < '0' || c > '8') {
+          return false;
+        }
+        out[c - '0'] = true;
+      }
+      return true;
+    }
+
+    // "lo..hi"
+    inline bool parse_range(std::string_view s, counts& out) {
+      int lo = 0, hi = 0;
+      if (!parse_int(s, lo) || s.substr(0, 2) != "..") {
+        return false;
+      }
+      s.remove_prefix(2);
+      if (!parse_int(s, hi) || !s.empty() || lo < 0 || hi > max_count || lo > hi) {
+        return false;
+      }
+      for (int n = lo; n <= hi; n++) {
+        out[n] = true;
+      }
+      return true;
+    }
+
+    inline std::optional<rule> parse_larger_than_life(std::string_view text) {
+      rule r;
+      r.include_centre = true;
+
+      while (!text.empty()) {
+        auto comma = text.find(',');
+        std::string_view field = text.substr(0, comma);
+        text = (comma == std::string_view::npos) ? std::string_view{} : text.substr(comma + 1);
+
+        if (field.empty()) {
+          return std::nullopt;
+        }
+
+        char key = field[0];
+        field.remove_prefix(1);
+        int value = 0;
+
+        switch (key) {
+          case 'R':
+            if (!parse_int(field, value) || !field.empty() || value < 1 || value > max_radius) {
+              return std::nullopt;
+            }
+            r.radius = value;
+            break;
+          case 'C':
+            if (!parse_int(field, value) || !field.empty() || value < 0 || value > 255) {
+              return std::nullopt;
+            }
+            r.states = value < 2 ? 2 : value;
+            break;
+          case 'M':
+            if (!parse_int(field, value) || !field.empty()) {
+              return std::nullopt;
+            }
+            r.include_centre = value != 0;
+            break;
+          case 'S':
+            if (!parse_range(field, r.survive)) {
+              return std::nullopt;
+            }
+            break;
+          case 'B':
+            if (!parse_range(field, r.birth)) {
+              return std::nullopt;
+            }
+            break;
+          default:
+            return std::nullopt;
+        }
+      }
+
+      // Ranges were read before R was known.
+      for (int n = r.neighbourhood() + 1; n <= max_count; n++) {
+        if (r.birth[n] || r.survive[n]) {
+          return std::nullopt;
+        }
+      }
+      return r;
+    }
+
+  }
+
+
+  inline std::optional<rule> rule::parse(std::string_view text) {
+    if (!text.empty() && text[0] == 'R') {
+      return detail::parse_larger_than_life(text);
+    }
+
+    rule r;
+    int field = 0;
+    while (!text.empty() || field == 0) {
+      auto slash = text.find('/');
+      std::string_view part = text.substr(0, slash);
+      text = (slash == std::string_view::npos) ? std::string_view{} : text.substr(slash + 1);
+
+      if (!part.empty() && (part[0] == 'B' || part[0] == 'b')) {
+        if (!detail::parse_digits(part.substr(1), r.birth)) return std::nullopt;
+      }
+      else if (!part.empty() && (part[0] == 'S' || part[0] == 's')) {
+        if (!detail::parse_digits(part.substr(1), r.survive)) return std::nullopt;
+      }
+      else if (field == 2) {
+        if (!part.empty() && (part[0] == 'C' || part[0] == 'G' || part[0] == 'c' || part[0] == 'g')) {
+          part.remove_prefix(1);
+        }
+        int states = 0;
+        if (!detail::parse_int(part, states) || !part.empty() || states < 2 || states > 255) {
+          return std::nullopt;
+        }
+        r.states = states;
+      }
+      else {
+        return std::nullopt;
+      }
+
+      if (++field > 3) {
+        return std::nullopt;
+      }
+    }
+    return r;
+  }
+
+
+}
@@ -0,0 +1,288 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+#include "geometry.h"
+#include "theme.h"
+
+
+namespace isolinear::ui {
+  class control;
+}
+
+
+namespace isolinear::animation {
+
+
+  using clock = std::chrono::steady_clock;
+  using handle = uint32_t;
+
+  enum easing { LINEAR, EASE_IN_OUT, STEP };
+  enum repeat { ONCE, LOOP, PING_PONG };
+
+
+  struct timing {
+    handle id;
+    ui::control* owner;
+    clock::time_point start;
+    clock::duration duration;
+    easing ease;
+    repeat mode;
+
+    // Eased progress in [0, 1]; sets finished once a ONCE tween has run.
+    // Tweens with no duration finish at once, at the end.
+    double progress(clock::time_point now, bool& finished) const {
+      if (duration <= clock::duration::zero()) {
+        finished = true;
+        return 1.0;
+      }
+
+      double t = std::chrono::duration<double>(now - start).count()
+               / std::chrono::duration<double>(duration).count();
+
+      switch (mode) {
+        case ONCE:
+          finished = t >= 1.0;
+          t = std::clamp(t, 0.0, 1.0);
+          break;
+        case LOOP:
+          t = t - std::floor(t);
+          break;
+        case PING_PONG:
+          t = t - 2.0 * std::floor(t / 2.0);
+          t = (t > 1.0) ? 2.0 - t : t;
+          break;
+      }
+
+      switch (ease) {
+        case LINEAR:      return t;
+        case EASE_IN_OUT: return t * t * (3.0 - 2.0 * t);
+        case STEP:        return (t < 0.5) ? 0.0 : 1.0;
+      }
+      return t;
+    }
+  };
+
+
+  struct colour_tween {
+    timing time;
+    theme::colour* target;
+    theme::colour from;
+    theme::colour to;
+  };
+
+  struct value_tween {
+    timing time;
+    std::function<void(double)> apply;
+    double from;
+    double to;
+  };
+
+  struct region_tween {
+    timing time;
+    geometry::region* target;
+    geometry::region from;
+    geometry::region to;
+  };
+
+
+  theme::colour lerp(theme::colour a, theme::colour b, double t) {
+    theme::colour out = 0;
+    for (int shift = 0; shift < 32; shift += 8) {
+      int ca = (a >> shift) & 0xff;
+      int cb = (b >> shift) & 0xff;
+      out |= static_cast<theme::colour>(std::lround(ca + (cb - ca) * t)) << shift;
+    }
+    return out;
+  }
+
+  int lerp(int a, int b, double t) {
+    return static_cast<int>(std::lround(a + (b - a) * t));
+  }
+
+  geometry::region lerp(geometry::region const& a, geometry::region const& b, double t) {
+    return geometry::region{
+        lerp(a.X(), b.X(), t), lerp(a.Y(), b.Y(), t),
+        lerp(a.W(), b.W(), t), lerp(a.H(), b.H(), t)
+    };
+  }
+
+
+  // Runs every active tween once per frame from the render loop's clock.
+  //
+  // Tweens of each kind live in their own contiguous array and are updated
+  // in a single pass; the controls they belong to are returned so their
+  // windows repaint. With nothing running, tick() is a single branch.
+  //
+  // Callbacks may start and cancel tweens. During a pass new tweens wait
+  // in a side array and cancelled ones are only marked, so the arrays
+  // being walked never change shape.
+  class scheduler {
+    protected:
+      template <typename T>
+      struct lane {
+        std::vector<T> running;
+        std::vector<T> started; // During tick(), joined after the pass
+
+        bool empty() const {
+          return running.empty() && started.empty();
+        }
+
+        std::size_t size() const {
+          return running.size() + started.size();
+        }
+      };
+
+      lane<colour_tween> m_colours;
+      lane<value_tween> m_values;
+      lane<region_tween> m_regions;
+      std::vector<ui::control*> m_touched;
+      handle m_next_id{1};
+      bool m_ticking{false};
+
+    public:
+      bool active() const {
+        return !m_colours.empty() || !m_values.empty() || !m_regions.empty();
+      }
+
+      std::size_t size() const {
+        return m_colours.size() + m_values.size() + m_regions.size();
+      }
+
+      handle colour(
+          theme::colour* target,
+          theme::colour from, theme::colour to,
+          clock::duration d,
+          ui::control* owner = nullptr,
+          easing e = LINEAR, repeat r = ONCE
+      ) {
+        *target = from;
+        return add(m_colours, {make_timing(owner, d, e, r), target, from, to});
+      }
+
+      handle value(
+          double from, double to,
+          clock::duration d,
+          std::function<void(double)> apply,
+          ui::control* owner = nullptr,
+          easing e = LINEAR, repeat r = ONCE
+      ) {
+        apply(from);
+        return add(m_values, {make_timing(owner, d, e, r), std::move(apply), from, to});
+      }
+
+      handle region(
+          geometry::region* target,
+          geometry::region from, geometry::region to,
+          clock::duration d,
+          ui::control* owner = nullptr,
+          easing e = LINEAR, repeat r = ONCE
+      ) {
+        *target = from;
+        return add(m_regions, {make_timing(owner, d, e, r), target, from, to});
+      }
+
+      bool cancel(handle id) {
+        return cancel_in(m_colours, id)
+            || cancel_in(m_values, id)
+            || cancel_in(m_regions, id);
+      }
+
+      // Advances every tween to now; returns the controls that changed.
+      std::vector<ui::control*> const& tick(clock::time_point now) {
+        m_touched.clear();
+        if (!active()) {
+          return m_touched;
+        }
+        m_ticking = true;
+
+        advance(m_colours, now, [](colour_tween& tw, double t) {
+          *tw.target = lerp(tw.from, tw.to, t);
+        });
+
+        advance(m_values, now, [](value_tween& tw, double t) {
+          tw.apply(tw.from + (tw.to - tw.from) * t);
+        });
+
+        advance(m_regions, now, [](region_tween& tw, double t) {
+          *tw.target = lerp(tw.from, tw.to, t);
+        });
+
+        m_ticking = false;
+        settle(m_colours);
+        settle(m_values);
+        settle(m_regions);
+
+        std::sort(m_touched.begin(), m_touched.end());
+        m_touched.erase(std::unique(m_touched.begin(), m_touched.end()), m_touched.end());
+        return m_touched;
+      }
+
+    protected:
+      timing make_timing(ui::control* owner, clock::duration d, easing e, repeat r) {
+        return timing{m_next_id++, owner, clock::now(), d, e, r};
+      }
+
+      template <typename T>
+      handle add(lane<T>& l, T tw) {
+        handle id = tw.time.id;
+        (m_ticking ? l.started : l.running).push_back(std::move(tw));
+        return id;
+      }
+
+      // Finished and cancelled tweens have id 0.
+      template <typename T, typename F>
+      void advance(lane<T>& l, clock::time_point now, F&& apply) {
+        for (std::size_t i = 0; i < l.running.size(); i++) {
+          T& tw = l.running[i];
+          if (tw.time.id == 0) {
+            continue;
+          }
+
+          bool finished = false;
+          apply(tw, tw.time.progress(now, finished));
+          if (tw.time.owner) {
+            m_touched.push_back(tw.time.owner);
+          }
+          if (finished) {
+            tw.time.id = 0;
+          }
+        }
+      }
+
+      template <typename T>
+      static void settle(lane<T>& l) {
+        std::erase_if(l.running, [](T const& tw) { return tw.time.id == 0; });
+        for (auto& tw : l.started) {
+          l.running.push_back(std::move(tw));
+        }
+        l.started.clear();
+      }
+
+      template <typename T>
+      bool cancel_in(lane<T>& l, handle id) {
+        auto match = [id](T const& tw) { return tw.time.id == id; };
+        if (std::erase_if(l.started, match) > 0) {
+          return true;
+        }
+
+        if (!m_ticking) {
+          return std::erase_if(l.running, match) > 0;
+        }
+
+        auto it = std::find_if(l.running.begin(), l.running.end(), match);
+        if (it == l.running.end()) {
+          return false;
+        }
+        it->time.id = 0;
+        return true;
+      }
+  };
+
+
+}
@@ -1,7 +1,9 @@
 #pragma once
 
 #include <list>
+#include <memory>
 #include <utility>
+#include <vector>
 
 #include <SDL2/SDL.h>
 #include <SDL2/SDL_ttf.h>
@@ -23,10 +25,29 @@ namespace isolinear::ui {
   class control {
     protected:
       layout::grid m_grid;
-      theme::colour_scheme m_colours;
+      std::shared_ptr<theme::palette> m_inherited_palette{theme::global_palette()};
+      std::shared_ptr<theme::palette> m_palette{m_inherited_palette};
+      bool m_palette_overridden{false};
       std::list<control*> m_children;
       bool m_mouse_within_bounds{false};
 
+      struct finger_state {
+        SDL_FingerID id;
+        bool pressed;
+      };
+      std::vector<finger_state> m_fingers_within_bounds;
+
+      int m_z_order{0};
+
+      control* m_parent{nullptr};
+
+      // Bumped on the root whenever its tree changes shape, so the window
+      // registry holding it knows its flattened draw order has gone stale.
+      unsigned m_tree_version{0};
+
+      // Set when something draw() shows has changed since the last frame.
+      bool m_changed{true};
+
     public:
       control(layout::grid g)
         : m_grid(g) {}
@@ -35,26 +56,180 @@ namespace isolinear::ui {
         return m_grid.bounds();
       }
 
-      virtual void draw(SDL_Renderer* renderer) const {
-        for (auto& child : m_children) {
-          child->draw(renderer);
+      // Draws this control only; children are drawn by the window registry.
+      virtual void draw(SDL_Renderer* renderer) const { }
+
+      const std::list<control*>& children() const {
+        return m_children;
+      }
+
+      int z_order() const {
+        return m_z_order;
+      }
+
+      void z_order(int z) {
+        m_z_order = z;
+        tree_changed();
+      }
+
+      control* parent() const {
+        return m_parent;
+      }
+
+      // For controls drawn by another without being registered as its
+      // child, so changes still reach a control the window draws.
+      void parent(control* p) {
+        m_parent = p;
+      }
+
+      control* root() {
+        control* c = this;
+        while (c->m_parent) {
+          c = c->m_parent;
+        }
+        return c;
+      }
+
+      unsigned tree_version() const {
+        return m_tree_version;
+      }
+
+      void tree_changed() {
+        ++root()->m_tree_version;
+        changed();
+      }
+
+      // Asks for a repaint. Call on the UI thread whenever something draw()
+      // reads has changed outside of an event handler.
+      void changed() {
+        for (control* c = this; c; c = c->m_parent) {
+          c->m_changed = true;
         }
       }
 
+      // Controls that poll for new content, or animate themselves, also
+      // report it here.
+      virtual bool needs_redraw() const {
+        return m_changed;
+      }
+
+      // Called by the window registry once the control has been drawn.
+      void drawn() {
+        m_changed = false;
+      }
+
       virtual bool pointer_is_hovering() const {
-          return m_mouse_within_bounds;
+          return m_mouse_within_bounds || finger_is_hovering();
+      }
+
+      bool finger_is_hovering() const {
+        return !m_fingers_within_bounds.empty();
+      }
+
+      bool finger_is_hovering(SDL_FingerID id) const {
+        return find_finger(id) >= 0;
+      }
+
+      bool finger_is_pressing(SDL_FingerID id) const {
+        int i = find_finger(id);
+        return i >= 0 && m_fingers_within_bounds[i].pressed;
       }
 
       void register_child(control* child) {
         m_children.push_back(child);
-        child->colours(colours());
+        child->m_parent = this;
+        child->inherit_palette(m_palette);
+        tree_changed();
       }
 
       void unregister_child(control* child) {
         m_children.remove(child);
+        child->m_parent = nullptr;
+        tree_changed();
       }
 
       virtual void on_pointer_event(event::pointer event) {
+        if (event.type() == event::FINGER) {
+          track_finger(event);
+        }
+        else {
+          track_mouse(event);
+        }
+      }
+
+      virtual void on_keyboard_event(event::keyboard event) { }
+
+      virtual void on_mouse_down(event::pointer event) { }
+      virtual void on_mouse_up(event::pointer event) { }
+      virtual void on_mouse_enter(event::pointer event) { }
+      virtual void on_mouse_leave(event::pointer event) { }
+
+      // Fingers fall back to the mouse handlers so existing widgets work on touch
+      virtual void on_finger_down(event::pointer event) { on_mouse_down(event); }
+      virtual void on_finger_up(event::pointer event) { on_mouse_up(event); }
+      virtual void on_finger_enter(event::pointer event) { }
+      virtual void on_finger_leave(event::pointer event) {
+        if (!finger_is_hovering()) on_mouse_leave(event);
+      }
+
+      virtual void on_gesture_event(event::gesture event) { }
+
+      virtual void on_wheel_event(event::wheel event) { }
+
+      const theme::colour_scheme& colours() const {
+        return m_palette->scheme();
+      }
+
+      unsigned colours_version() const {
+        return m_palette->version();
+      }
+
+      std::shared_ptr<theme::palette> const& palette() const {
+        return m_palette;
+      }
+
+      // Called by the parent with the palette this control shares unless it
+      // has overridden its own.
+      void inherit_palette(std::shared_ptr<theme::palette> p) {
+        m_inherited_palette = std::move(p);
+        if (!m_palette_overridden) {
+          m_palette = m_inherited_palette;
+          on_palette_changed();
+        }
+      }
+
+      // Overrides the colours of this control and its subtree.
+      void colours(theme::colour_scheme cs) {
+        if (m_palette_overridden) {
+          m_palette->scheme(cs);
+          changed();
+          return;
+        }
+
+        m_palette = std::make_shared<theme::palette>(cs);
+        m_palette_overridden = true;
+        on_palette_changed();
+      }
+
+      void clear_colours_override() {
+        if (!m_palette_overridden) {
+          return;
+        }
+
+        m_palette = m_inherited_palette;
+        m_palette_overridden = false;
+        on_palette_changed();
+      }
+
+    protected:
+      virtual void on_palette_changed() {
+        for (auto& child : m_children) {
+          child->inherit_palette(m_palette);
+        }
+        changed();
+      }
+
+      void track_mouse(event::pointer event) {
         bool within_bounds = bounds().encloses(event.position());
 
         if (within_bounds && !m_mouse_within_bounds) {
@@ -71,32 +246,46 @@ namespace isolinear::ui {
           if (event.is_mouse_down()) on_mouse_down(event);
           if (event.is_mouse_up()) on_mouse_up(event);
         }
+      }
 
-        for (auto& child : m_children) {
-          child->on_pointer_event(event);
+      void track_finger(event::pointer event) {
+        bool within_bounds = bounds().encloses(event.position());
+        int i = find_finger(event.finger_id());
+
+        if (within_bounds && i < 0) {
+          m_fingers_within_bounds.push_back({event.finger_id(), false});
+          i = static_cast<int>(m_fingers_within_bounds.size()) - 1;
+          on_finger_enter(event);
         }
-      }
 
-      virtual void on_keyboard_event(event::keyboard event) {
-        for (auto& child : m_children) {
-          child->on_keyboard_event(event);
+        if (!within_bounds) {
+          if (i >= 0) {
+            m_fingers_within_bounds.erase(m_fingers_within_bounds.begin() + i);
+            on_finger_leave(event);
+          }
+          return;
         }
-      }
 
-      virtual void on_mouse_down(event::pointer event) { }
-      virtual void on_mouse_up(event::pointer event) { }
-      virtual void on_mouse_enter(event::pointer event) { }
-      virtual void on_mouse_leave(event::pointer event) { }
+        if (event.is_finger_down()) {
+          m_fingers_within_bounds[i].pressed = true;
+          on_finger_down(event);
+        }
 
-      virtual theme::colour_scheme colours() const {
-        return m_colours;
+        if (event.is_finger_up()) {
+          bool was_pressed = m_fingers_within_bounds[i].pressed;
+          m_fingers_within_bounds.erase(m_fingers_within_bounds.begin() + i);
+          if (was_pressed) on_finger_up(event);
+          on_finger_leave(event);
+        }
       }
 
-      virtual void colours(theme::colour_scheme cs) {
-        m_colours = cs;
-        for (auto& child : m_children) {
-          child->colours(cs);
+      int find_finger(SDL_FingerID id) const {
+        for (std::size_t i = 0; i < m_fingers_within_bounds.size(); i++) {
+          if (m_fingers_within_bounds[i].id == id) {
+            return static_cast<int>(i);
+          }
         }
+        return -1;
       }
   };
 
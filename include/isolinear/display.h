@@ -1,5 +1,6 @@
 #pragma once
 
+#include <array>
 #include <exception>
 #include <list>
 #include <stdexcept>
@@ -12,9 +13,10 @@
 #include "control.h"
 #include "theme.h"
 #include "geometry.h"
+#include "log.h"
 #include "text.h"
-
-#define FONT "/home/daniel/.fonts/Swiss 911 Ultra Compressed Regular.otf"
+#include "touch.h"
+#include "registry.h"
 
 
 namespace isolinear::display {
@@ -31,9 +33,9 @@ namespace isolinear::display {
       SDL_Renderer* m_sdl_renderer{nullptr};
 
     protected: // Fonts
-      const text::font m_header_font{ FONT, 60, 0xff0099ff };
-      const text::font m_button_font{ FONT, 30, 0xff000000 };
-      const text::font  m_label_font{ FONT, 30, 0xff0099ff };
+      const text::font m_header_font{ 60, 0xff0099ff };
+      const text::font m_button_font{ 30, 0xff000000 };
+      const text::font  m_label_font{ 30, 0xff0099ff };
 
 
     public: // Constructors & Destructors
@@ -51,27 +53,49 @@ namespace isolinear::display {
       }
 
     public: // ui::control interface
-      theme::colour_scheme colours() {
-        return m_colours;
+      const theme::colour_scheme& colours() const {
+        return m_palette->scheme();
+      }
+
+      // Swaps the scheme in the window's palette, so every control in it
+      // follows. Other windows only change if they share the palette.
+      void colours(const theme::colour_scheme& cs) {
+        m_palette->scheme(cs);
       }
 
-      void colours(theme::colour_scheme cs) {
-        m_colours = cs;
+      std::shared_ptr<theme::palette> const& palette() const {
+        return m_palette;
+      }
+
+      // Shares p, e.g. theme::global_palette(), with other windows.
+      void palette(std::shared_ptr<theme::palette> p) {
+        m_palette = std::move(p);
         for (auto* drawable : m_drawables) {
-          drawable->colours(cs);
+          drawable->inherit_palette(m_palette);
         }
+        redraw();
       }
 
       void draw() const {
-        for (auto* drawable : m_drawables) {
-          drawable->draw(m_sdl_renderer);
-        }
+        controls().draw(m_sdl_renderer);
       }
 
-      void render() const {
+      // Repaints the whole window for the next render.
+      void redraw() {
+        m_redraw = true;
+      }
+
+      // Only repaints when a control, the palette or the window itself has
+      // changed; false if there was nothing to draw.
+      bool render() const {
+        bool dirty = controls().collect();
+        if (!dirty && !m_redraw && m_drawn_palette_version == m_palette->version()) {
+          return false;
+        }
+
         theme::colour unpack_colour = (m_override_background > 0)
                                     ? m_override_background
-                                    : m_colours.background;
+                                    : colours().background;
 
         uint8_t blue = unpack_colour;
         uint8_t green = unpack_colour >> 8;
@@ -84,24 +108,48 @@ namespace isolinear::display {
         draw();
 
         SDL_RenderPresent(m_sdl_renderer);
+
+        m_redraw = false;
+        m_drawn_palette_version = m_palette->version();
+        return true;
       }
 
       void on_pointer_event(event::pointer event) {
-        set_title(fmt::format("Mouse X={} Y={}", event.position().x, event.position().y));
+        auto end = fmt::format_to_n(
+            m_pointer_title.begin(), m_pointer_title.size() - 1,
+            "Mouse X={} Y={}", event.position().x, event.position().y
+        ).out;
+        *end = '\0';
+        SDL_SetWindowTitle(m_sdl_window.get(), m_pointer_title.data());
+        controls().dispatch(event);
+      }
 
-        for (auto* drawable : m_drawables) {
-          drawable->on_pointer_event(event);
-        }
+      void on_finger_event(event::pointer event) {
+        controls().dispatch(event);
+
+        m_touch.track(event, [this](event::gesture g){ on_gesture_event(g); });
+      }
+
+      void on_gesture_event(event::gesture event) {
+        controls().dispatch(event);
+      }
+
+      void update_gestures(Uint32 now) {
+        m_touch.update(now, [this](event::gesture g){ on_gesture_event(g); });
       }
 
       void on_keyboard_event(event::keyboard event) {
-        for (auto* drawable : m_drawables) {
-          drawable->on_keyboard_event(event);
-        }
+        controls().dispatch(event);
+      }
+
+      void on_wheel_event(event::wheel event) {
+        controls().dispatch(event);
       }
 
       void on_window_event(event::window event) {
-        std::cout << fmt::format("Window {} resized.\n", window_id());
+        log::info("Window {} resized.", window_id());
+        controls().refresh_bounds();
+        redraw();
       }
 
     public: // Accessors
@@ -112,11 +160,24 @@ namespace isolinear::display {
       [[nodiscard]] geometry::region region() const { return geometry::region{m_position, m_size}; }
       [[nodiscard]] SDL_Renderer* renderer() const { return m_sdl_renderer; }
 
+      [[nodiscard]] ui::registry& controls() const {
+        if (m_registry.stale(m_drawables)) {
+          m_registry.rebuild(m_drawables);
+        }
+        return m_registry;
+      }
+
     protected: // Protected window properties
       std::string m_title{"Isolinear"};
+      std::array<char, 48> m_pointer_title{}; // Formatted in place on pointer motion
       std::list<ui::control*> m_drawables;
-      theme::colour_scheme m_colours;
+      mutable ui::registry m_registry;
+      // Starts as a copy of the app-wide scheme
+      std::shared_ptr<theme::palette> m_palette{std::make_shared<theme::palette>(theme::global_palette()->scheme())};
       theme::colour m_override_background = 0x00000000;
+      mutable bool m_redraw{true};
+      mutable unsigned m_drawn_palette_version{0};
+      touch::tracker m_touch;
 
   public: // Public window methods
       void set_title(const std::string& new_title) {
@@ -125,7 +186,7 @@ namespace isolinear::display {
 
       void add(ui::control* drawable) {
         m_drawables.push_back(drawable);
-        drawable->colours(colours());
+        drawable->inherit_palette(m_palette);
       }
 
       uint32_t window_id() const {
@@ -171,7 +232,7 @@ namespace isolinear::display {
   std::vector<geometry::region> detect_displays() {
     std::vector<geometry::region> displays;
 
-    fmt::print("Detecting displays:\n");
+    log::info("Detecting displays:");
 
     int number_of_displays = SDL_GetNumVideoDisplays();
     for (int i = 0; i < number_of_displays; i++) {
@@ -179,7 +240,7 @@ namespace isolinear::display {
       SDL_GetDisplayBounds(i, &bounds);
       displays.emplace_back(bounds);
 
-      fmt::print("  {}: {},{} +({},{}) [{}]\n",
+      log::info("  {}: {},{} +({},{}) [{}]",
           i,
           bounds.w, bounds.h,
           bounds.x, bounds.y,
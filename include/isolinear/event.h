@@ -53,14 +53,24 @@ namespace isolinear::event {
     protected:
         geometry::position m_position;
         pointer_type m_type;
+        Uint32 m_timestamp{0};
+        SDL_FingerID m_finger_id{0};
         bool m_is_mouse_down{false};
         bool m_is_mouse_up{false};
+        bool m_is_finger_down{false};
+        bool m_is_finger_up{false};
 
     public:
-        explicit pointer(SDL_MouseMotionEvent e) : m_position{e.x, e.y}, m_type{MOUSE} {};
+        explicit pointer(SDL_MouseMotionEvent e)
+          : m_position{e.x, e.y}
+          , m_type{MOUSE}
+          , m_timestamp{e.timestamp}
+          {};
+
         explicit pointer(SDL_MouseButtonEvent e)
           : m_position{e.x, e.y}
           , m_type{MOUSE}
+          , m_timestamp{e.timestamp}
           , m_is_mouse_down{e.type == SDL_MOUSEBUTTONDOWN}
           , m_is_mouse_up{e.type == SDL_MOUSEBUTTONUP}
           {};
@@ -70,7 +80,11 @@ namespace isolinear::event {
                 static_cast<int>(ws.x * e.x),
                 static_cast<int>(ws.y * e.y)
               },
-              m_type{FINGER} {};
+              m_type{FINGER},
+              m_timestamp{e.timestamp},
+              m_finger_id{e.fingerId},
+              m_is_finger_down{e.type == SDL_FINGERDOWN},
+              m_is_finger_up{e.type == SDL_FINGERUP} {};
 
         geometry::position position() const {
           return m_position;
@@ -80,6 +94,14 @@ namespace isolinear::event {
           return m_type;
         }
 
+        Uint32 timestamp() const {
+          return m_timestamp;
+        }
+
+        SDL_FingerID finger_id() const {
+          return m_finger_id;
+        }
+
         bool is_mouse_down() const {
           return m_is_mouse_down;
         }
@@ -87,6 +109,123 @@ namespace isolinear::event {
         bool is_mouse_up() const {
           return m_is_mouse_up;
         }
+
+        bool is_finger_down() const {
+          return m_is_finger_down;
+        }
+
+        bool is_finger_up() const {
+          return m_is_finger_up;
+        }
+
+        bool is_finger_motion() const {
+          return m_type == FINGER && !m_is_finger_down && !m_is_finger_up;
+        }
+    };
+
+
+    class wheel {
+
+    protected:
+        geometry::position m_position;
+        int m_x;
+        int m_y;
+        Uint32 m_timestamp;
+
+    public:
+        // SDL wheel events carry no position, so the pointer's is passed in.
+        wheel(SDL_MouseWheelEvent e, geometry::position p)
+          : m_position{p}
+          , m_x{e.direction == SDL_MOUSEWHEEL_FLIPPED ? -e.x : e.x}
+          , m_y{e.direction == SDL_MOUSEWHEEL_FLIPPED ? -e.y : e.y}
+          , m_timestamp{e.timestamp}
+          {};
+
+        geometry::position position() const {
+          return m_position;
+        }
+
+        // Positive away from the user.
+        int y() const {
+          return m_y;
+        }
+
+        // Positive to the right.
+        int x() const {
+          return m_x;
+        }
+
+        Uint32 timestamp() const {
+          return m_timestamp;
+        }
+    };
+
+
+    enum gesture_type { TAP, LONG_PRESS, SWIPE };
+
+
+    class gesture {
+
+    protected:
+        gesture_type m_type;
+        SDL_FingerID m_finger_id;
+        geometry::position m_origin;
+        geometry::position m_position;
+        Uint32 m_duration;
+        compass m_direction;
+
+    public:
+        gesture(
+            gesture_type t,
+            SDL_FingerID f,
+            geometry::position o,
+            geometry::position p,
+            Uint32 d,
+            compass dir = compass::centre
+        )
+          : m_type{t}
+          , m_finger_id{f}
+          , m_origin{o}
+          , m_position{p}
+          , m_duration{d}
+          , m_direction{dir}
+          {};
+
+        event::gesture_type type() const {
+          return m_type;
+        }
+
+        SDL_FingerID finger_id() const {
+          return m_finger_id;
+        }
+
+        geometry::position origin() const {
+          return m_origin;
+        }
+
+        geometry::position position() const {
+          return m_position;
+        }
+
+        Uint32 duration() const {
+          return m_duration;
+        }
+
+        compass direction() const {
+          return m_direction;
+        }
+
+        bool is_tap() const {
+          return m_type == TAP;
+        }
+
+        bool is_long_press() const {
+          return m_type == LONG_PRESS;
+        }
+
+        bool is_swipe() const {
+          return m_type == SWIPE;
+        }
     };
 
 }
@@ -0,0 +1,236 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <functional>
+#include <memory>
+#include <memory_resource>
+#include <mutex>
+#include <new>
+#include <utility>
+#include <vector>
+
+
+namespace isolinear::frame {
+
+
+  // Heap allocations made by the current thread, through operator new or
+  // SDL. Only counted when the program defines ISOLINEAR_COUNT_ALLOCATIONS
+  // before including isolinear.
+  inline thread_local std::size_t allocations{0};
+
+
+  // Per-frame allocation meter, driven by the render loop.
+  class meter {
+    protected:
+      std::size_t m_start{0};
+      std::size_t m_last{0};
+      uint64_t m_frames{0};
+      std::function<void(uint64_t, std::size_t)> m_hook;
+
+    public:
+      void begin() {
+        m_start = allocations;
+      }
+
+      void end() {
+        m_last = allocations - m_start;
+        ++m_frames;
+        if (m_hook) {
+          m_hook(m_frames, m_last);
+        }
+      }
+
+      // Allocations made during the last completed frame.
+      std::size_t last_allocations() const {
+        return m_last;
+      }
+
+      uint64_t frames() const {
+        return m_frames;
+      }
+
+      // Called after every frame with the frame number and its allocations.
+      void on_frame(std::function<void(uint64_t, std::size_t)> hook) {
+        m_hook = std::move(hook);
+      }
+  };
+
+
+  meter& stats() {
+    static meter m;
+    return m;
+  }
+
+
+  // Scratch memory for the UI thread, released at the start of every
+  // frame. Anything allocated from it must not outlive the frame.
+  class arena {
+    protected:
+      static constexpr std::size_t capacity = 64 * 1024;
+
+      std::unique_ptr<std::byte[]> m_buffer{new std::byte[capacity]};
+      std::pmr::monotonic_buffer_resource m_resource{m_buffer.get(), capacity};
+
+    public:
+      std::pmr::memory_resource* resource() {
+        return &m_resource;
+      }
+
+      void reset() {
+        m_resource.release();
+      }
+  };
+
+
+  arena& scratch() {
+    static arena a;
+    return a;
+  }
+
+
+  // Work deferred to the UI thread, run once at the start of the next frame.
+  //
+  // Any thread may push. Tasks are tagged with an owner so an object that
+  // dies with work still queued can withdraw it, including work in the
+  // batch being run, e.g. when an earlier task in it destroys the owner.
+  class queue {
+    protected:
+      struct task {
+        const void* owner;
+        std::function<void()> fn;
+      };
+
+      std::mutex m_mutex;
+      std::vector<task> m_pending;
+      std::vector<task> m_running;
+
+    public:
+      void push(const void* owner, std::function<void()> fn) {
+        std::lock_guard lock(m_mutex);
+        m_pending.push_back({owner, std::move(fn)});
+      }
+
+      void cancel(const void* owner) {
+        std::lock_guard lock(m_mutex);
+        std::erase_if(m_pending, [owner](task const& t) { return t.owner == owner; });
+        for (auto& t : m_running) {
+          if (t.owner == owner) {
+            t.fn = nullptr;
+          }
+        }
+      }
+
+      bool empty() {
+        std::lock_guard lock(m_mutex);
+        return m_pending.empty();
+      }
+
+      // False if there was nothing to run.
+      bool run() {
+        {
+          std::lock_guard lock(m_mutex);
+          if (m_pending.empty()) {
+            return false;
+          }
+          m_running.swap(m_pending);
+        }
+
+        for (std::size_t i = 0;; i++) {
+          std::function<void()> fn;
+          {
+            std::lock_guard lock(m_mutex);
+            if (i == m_running.size()) {
+              m_running.clear();
+              break;
+            }
+            fn = std::move(m_running[i].fn);
+          }
+          if (fn) {
+            fn();
+          }
+        }
+        return true;
+      }
+  };
+
+
+  queue& deferred() {
+    static queue q;
+    return q;
+  }
+
+
+}
+
+
+#ifdef ISOLINEAR_COUNT_ALLOCATIONS
+// Every replaceable form of operator new is counted; the array and
+// nothrow forms go through the plain and aligned ones. SDL's allocations
+// are routed through the same counter by isolinear::init().
+void* operator new(std::size_t n) {
+  ++isolinear::frame::allocations;
+  if (void* p = std::malloc(n ? n : 1)) {
+    return p;
+  }
+  throw std::bad_alloc();
+}
+
+void* operator new(std::size_t n, std::align_val_t al) {
+  ++isolinear::frame::allocations;
+  auto alignment = static_cast<std::size_t>(al);
+  std::size_t rounded = ((n ? n : 1) + alignment - 1) / alignment * alignment;
+  if (void* p = std::aligned_alloc(alignment, rounded)) {
+    return p;
+  }
+  throw std::bad_alloc();
+}
+
+void* operator new[](std::size_t n) {
+  return ::operator new(n);
+}
+
+void* operator new[](std::size_t n, std::align_val_t al) {
+  return ::operator new(n, al);
+}
+
+void* operator new(std::size_t n, const std::nothrow_t&) noexcept {
+  try {
+    return ::operator new(n);
+  }
+  catch (std::bad_alloc const&) {
+    return nullptr;
+  }
+}
+
+void* operator new(std::size_t n, std::align_val_t al, const std::nothrow_t&) noexcept {
+  try {
+    return ::operator new(n, al);
+  }
+  catch (std::bad_alloc const&) {
+    return nullptr;
+  }
+}
+
+void* operator new[](std::size_t n, const std::nothrow_t& nt) noexcept {
+  return ::operator new(n, nt);
+}
+
+void* operator new[](std::size_t n, std::align_val_t al, const std::nothrow_t& nt) noexcept {
+  return ::operator new(n, al, nt);
+}
+
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+void operator delete(void* p, std::align_val_t) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t, std::align_val_t) noexcept { std::free(p); }
+void operator delete(void* p, const std::nothrow_t&) noexcept { std::free(p); }
+void operator delete(void* p, std::align_val_t, const std::nothrow_t&) noexcept { std::free(p); }
+void operator delete[](void* p) noexcept { std::free(p); }
+void operator delete[](void* p, std::size_t) noexcept { std::free(p); }
+void operator delete[](void* p, std::align_val_t) noexcept { std::free(p); }
+void operator delete[](void* p, std::size_t, std::align_val_t) noexcept { std::free(p); }
+void operator delete[](void* p, const std::nothrow_t&) noexcept { std::free(p); }
+void operator delete[](void* p, std::align_val_t, const std::nothrow_t&) noexcept { std::free(p); }
+#endif
@@ -10,9 +10,11 @@
 #include <asio.hpp>
 #include <map>
 
+#include "animation.h"
 #include "display.h"
 #include "window.h"
 #include "event.h"
+#include "frame.h"
 
 
 namespace isolinear {
@@ -21,17 +23,52 @@ namespace isolinear {
   std::thread io_thread;
   std::list<display::window> window_list{};
   std::map<uint32_t, display::window&> window_map{};
+  animation::scheduler animations;
+
+  // Set after a frame that drew nothing, so the next one waits for input
+  // instead of spinning. The wait is capped at a frame so work arriving
+  // from other threads is still picked up promptly.
+  bool idle{false};
+  constexpr int idle_wait_ms = 16;
 
   void init() {
     srand(time(NULL));
 
+#ifdef ISOLINEAR_COUNT_ALLOCATIONS
+    // SDL and SDL_ttf allocate surfaces, textures and the like with
+    // SDL_malloc; count those alongside operator new.
+    SDL_SetMemoryFunctions(
+        [](size_t n) { ++frame::allocations; return std::malloc(n); },
+        [](size_t n, size_t size) { ++frame::allocations; return std::calloc(n, size); },
+        [](void* p, size_t n) { ++frame::allocations; return std::realloc(p, n); },
+        std::free
+    );
+#endif
+
     SDL_Init(SDL_INIT_VIDEO);
     TTF_Init();
 
     io_thread = std::thread([](){ io_context.run(); });
   }
 
+  // Touch devices without window focus send to the first window; nullptr
+  // if there are no windows to send to.
+  display::window* finger_window(SDL_TouchFingerEvent e) {
+    auto it = window_map.find(e.windowID);
+    if (it != window_map.end()) {
+      return &it->second;
+    }
+    return window_list.empty() ? nullptr : &window_list.front();
+  }
+
   bool loop() {
+    if (idle) {
+      SDL_WaitEventTimeout(nullptr, idle_wait_ms);
+    }
+
+    frame::stats().begin();
+    frame::scratch().reset();
+
     SDL_Event e;
     while (SDL_PollEvent(&e) != 0) {
       switch (e.type) {
@@ -45,19 +82,41 @@ namespace isolinear {
           break;
 
         case SDL_MOUSEMOTION:
+          if (e.motion.which == SDL_TOUCH_MOUSEID) break; // Handled as a finger
           window_map.at(e.key.windowID).on_pointer_event(event::pointer(e.motion));
           break;
 
         case SDL_MOUSEBUTTONDOWN:
         case SDL_MOUSEBUTTONUP:
+          if (e.button.which == SDL_TOUCH_MOUSEID) break;
           window_map.at(e.button.windowID).on_pointer_event(event::pointer(e.button));
           break;
 
+        case SDL_MOUSEWHEEL: {
+          if (e.wheel.which == SDL_TOUCH_MOUSEID) break;
+          int x = 0, y = 0;
+          SDL_GetMouseState(&x, &y);
+          window_map.at(e.wheel.windowID).on_wheel_event(event::wheel(e.wheel, {x, y}));
+          break;
+        }
+
+        case SDL_FINGERDOWN:
+        case SDL_FINGERUP:
+        case SDL_FINGERMOTION: {
+          if (auto* window = finger_window(e.tfinger)) {
+            window->on_finger_event(event::pointer(e.tfinger, window->size()));
+          }
+          break;
+        }
+
         case SDL_WINDOWEVENT:
           switch (e.window.event) {
             case SDL_WINDOWEVENT_RESIZED:
               window_map.at(e.window.windowID).on_window_event(event::window(e.window));
               break;
+            case SDL_WINDOWEVENT_EXPOSED:
+              window_map.at(e.window.windowID).redraw();
+              break;
           }
           break;
 
@@ -66,10 +125,32 @@ namespace isolinear {
       }
     }
 
+    // Deferred work is finished text, progress and the like, arriving
+    // from other threads for controls that cannot say which window they
+    // are in.
+    if (frame::deferred().run()) {
+      for (auto& window : window_list) {
+        window.redraw();
+      }
+    }
+
+    if (animations.active()) {
+      for (auto* control : animations.tick(animation::clock::now())) {
+        for (auto& window : window_list) {
+          window.controls().mark_dirty(control);
+        }
+      }
+    }
+
+    Uint32 now = SDL_GetTicks();
+    bool drawn = false;
     for (auto& window : window_list) {
-      window.render();
+      window.update_gestures(now);
+      drawn = window.render() || drawn;
     }
+    idle = !drawn && !animations.active();
 
+    frame::stats().end();
     return true;
   }
 
@@ -81,7 +162,6 @@ namespace isolinear {
   display::window& new_window(geometry::vector position, geometry::vector size) {
     window_list.emplace_back(position, size);
     auto& window = window_list.back();
-    window.colours(isolinear::theme::nightgazer_colours);
     window_map.emplace(window.window_id(), window);
     return window;
   }
@@ -6,7 +6,10 @@
 #include <SDL2/SDL_ttf.h>
 #include <SDL2/SDL2_gfxPrimitives.h>
 
+#include <cstdint>
+#include <memory>
 #include <utility>
+#include <vector>
 
 #include "geometry.h"
 #include "control.h"
@@ -180,6 +183,10 @@ namespace isolinear::layout {
           return m_gutter;
         }
 
+        geometry::vector cell_size() const {
+          return m_cell_size;
+        }
+
         geometry::region bounds() const {
           return m_bounds;
         }
@@ -192,6 +199,100 @@ namespace isolinear::layout {
         }
     };
 
+    // Chunked arena for grids handed out by a gridfactory.
+    //
+    // Grids never move once placed, so references stay valid until reset().
+    // reset() destroys every grid but keeps the chunks for the next layout.
+    class grid_arena {
+      public:
+        using handle = uint32_t;
+
+        struct statistics {
+            std::size_t grids;
+            std::size_t peak_grids;
+            std::size_t capacity;
+            std::size_t chunks;
+            std::size_t bytes_reserved;
+            std::size_t bytes_used;
+            std::size_t resets;
+        };
+
+      protected:
+        static constexpr handle chunk_shift = 6;
+        static constexpr handle chunk_size = handle{1} << chunk_shift;
+        static constexpr handle chunk_mask = chunk_size - 1;
+
+        std::allocator<grid> m_allocator;
+        std::vector<grid*> m_chunks;
+        handle m_count{0};
+        std::size_t m_peak{0};
+        std::size_t m_resets{0};
+
+      public:
+        grid_arena() = default;
+        grid_arena(const grid_arena&) = delete;
+        grid_arena& operator=(const grid_arena&) = delete;
+
+        ~grid_arena() {
+          reset();
+          for (auto* chunk : m_chunks) {
+            m_allocator.deallocate(chunk, chunk_size);
+          }
+        }
+
+        template <typename... Args>
+        handle emplace(Args&&... args) {
+          if (m_count == capacity()) {
+            m_chunks.push_back(m_allocator.allocate(chunk_size));
+          }
+
+          std::construct_at(slot(m_count), std::forward<Args>(args)...);
+          m_peak = std::max<std::size_t>(m_peak, m_count + 1);
+          return m_count++;
+        }
+
+        grid& operator[](handle h) {
+          return *slot(h);
+        }
+
+        const grid& operator[](handle h) const {
+          return *slot(h);
+        }
+
+        std::size_t size() const {
+          return m_count;
+        }
+
+        std::size_t capacity() const {
+          return m_chunks.size() * chunk_size;
+        }
+
+        void reset() {
+          for (handle h = 0; h < m_count; h++) {
+            std::destroy_at(slot(h));
+          }
+          m_count = 0;
+          ++m_resets;
+        }
+
+        statistics stats() const {
+          return {
+              m_count,
+              m_peak,
+              capacity(),
+              m_chunks.size(),
+              capacity() * sizeof(grid),
+              m_count * sizeof(grid),
+              m_resets
+          };
+        }
+
+      protected:
+        grid* slot(handle h) const {
+          return m_chunks[h >> chunk_shift] + (h & chunk_mask);
+        }
+    };
+
     class gridfactory {
       protected:
         geometry::vector m_cell_size{100, 50};
@@ -199,9 +300,11 @@ namespace isolinear::layout {
         geometry::vector m_gutter{0};
         geometry::region m_bounds;
         geometry::vector m_offset{0};
-        std::list<grid> m_grids{};
+        grid_arena m_grids;
 
       public:
+        using handle = grid_arena::handle;
+
         gridfactory(
             geometry::region b,
             geometry::vector cs,
@@ -221,6 +324,13 @@ namespace isolinear::layout {
         grid &subgrid(
             int near_col, int near_row,
             int far_col, int far_row
+        ) {
+          return m_grids[subgrid_handle(near_col, near_row, far_col, far_row)];
+        }
+
+        handle subgrid_handle(
+            int near_col, int near_row,
+            int far_col, int far_row
         ) {
           if (far_col < 0) { far_col = m_size.x + far_col; }
           if (far_row < 0) { far_row = m_size.y + far_row; }
@@ -234,8 +344,28 @@ namespace isolinear::layout {
               far_row - near_row + 1
           );
           geometry::vector offset(0, 0);
-          m_grids.emplace_back(region, m_cell_size, m_gutter, size, offset);
-          return m_grids.back();
+          return m_grids.emplace(region, m_cell_size, m_gutter, size, offset);
+        }
+
+        grid &at(handle h) {
+          return m_grids[h];
+        }
+
+        // Drops every grid handed out so far; references and handles from
+        // before the reset are invalid afterwards.
+        void reset() {
+          m_grids.reset();
+        }
+
+        void relayout(geometry::region b) {
+          m_bounds = b;
+          m_size = {b.W() / m_cell_size.x, b.H() / m_cell_size.y};
+          m_offset = {(b.W() % m_cell_size.x) / 2, (b.H() % m_cell_size.y) / 2};
+          reset();
+        }
+
+        grid_arena::statistics stats() const {
+          return m_grids.stats();
         }
 
         geometry::region calculate_grid_region(int near_col, int near_row, int far_col, int far_row) const {
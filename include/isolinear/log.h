@@ -0,0 +1,240 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <string_view>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <fmt/core.h>
+
+#include "ring.h"
+
+
+// Records below this level are compiled out: 0 trace, 1 debug, 2 info,
+// 3 warn, 4 error, 5 off.
+#ifndef ISOLINEAR_LOG_LEVEL
+#ifdef NDEBUG
+#define ISOLINEAR_LOG_LEVEL 2
+#else
+#define ISOLINEAR_LOG_LEVEL 1
+#endif
+#endif
+
+
+namespace isolinear::log {
+
+
+  enum class level : uint8_t { trace, debug, info, warn, error, off };
+
+  constexpr level compiled_level = static_cast<level>(ISOLINEAR_LOG_LEVEL);
+
+  using clock = std::chrono::steady_clock;
+
+
+  struct record {
+    clock::time_point time;
+    level severity;
+    uint16_t thread;
+    uint16_t length;
+    char text[236];
+  };
+
+
+  // Asynchronous log sink.
+  //
+  // Each thread formats into a fixed-size record and pushes it onto its
+  // own lock-free ring, so logging never takes a lock or touches the
+  // terminal. A background thread drains every ring in time order and
+  // writes the batch out. Records that do not fit in a full ring are
+  // dropped and counted.
+  class sink {
+    protected:
+      using buffer = spsc_ring<record, 256>;
+
+      struct slot {
+        std::shared_ptr<buffer> ring; // Shared so records outlive their thread
+        uint16_t index;
+      };
+
+      std::mutex m_mutex; // Guards the buffer list, not the buffers
+      std::vector<std::shared_ptr<buffer>> m_buffers;
+      std::vector<record> m_batch;
+
+      std::atomic<level> m_threshold{compiled_level};
+      std::atomic<std::size_t> m_dropped{0};
+      std::FILE* m_out{stderr};
+      clock::time_point m_epoch{clock::now()};
+      std::chrono::milliseconds m_interval{20};
+
+      std::mutex m_wake_mutex;
+      std::condition_variable m_wake;
+      bool m_stopping{false};
+      std::thread m_thread;
+
+    public:
+      sink() {
+        m_thread = std::thread([this]() { run(); });
+      }
+
+      sink(const sink&) = delete;
+      sink& operator=(const sink&) = delete;
+
+      ~sink() {
+        {
+          std::lock_guard lock(m_wake_mutex);
+          m_stopping = true;
+        }
+        m_wake.notify_one();
+        m_thread.join();
+        flush();
+      }
+
+      // Runtime threshold, on top of the compiled one.
+      void threshold(level l) {
+        m_threshold.store(l, std::memory_order_relaxed);
+      }
+
+      level threshold() const {
+        return m_threshold.load(std::memory_order_relaxed);
+      }
+
+      std::size_t dropped() const {
+        return m_dropped.load(std::memory_order_relaxed);
+      }
+
+      void submit(record const& r) {
+        if (!local().ring->push(r)) {
+          m_dropped.fetch_add(1, std::memory_order_relaxed);
+        }
+      }
+
+      uint16_t thread_index() {
+        return local().index;
+      }
+
+      // Writes out everything queued so far. Normally called by the
+      // background thread only.
+      void flush() {
+        std::lock_guard lock(m_mutex);
+
+        m_batch.clear();
+        for (auto& b : m_buffers) {
+          b->drain([this](record const& r) { m_batch.push_back(r); });
+        }
+
+        if (m_batch.empty()) {
+          return;
+        }
+
+        std::stable_sort(m_batch.begin(), m_batch.end(), [](record const& a, record const& b) {
+          return a.time < b.time;
+        });
+
+        for (auto const& r : m_batch) {
+          double seconds = std::chrono::duration<double>(r.time - m_epoch).count();
+          fmt::print(m_out, "[{:10.3f}] {} #{} {}\n",
+              seconds, name(r.severity), r.thread,
+              std::string_view{r.text, r.length}
+          );
+        }
+        std::fflush(m_out);
+      }
+
+      static const char* name(level l) {
+        switch (l) {
+          case level::trace: return "TRACE";
+          case level::debug: return "DEBUG";
+          case level::info:  return "INFO ";
+          case level::warn:  return "WARN ";
+          case level::error: return "ERROR";
+          case level::off:   break;
+        }
+        return "?????";
+      }
+
+    protected:
+      slot& local() {
+        static thread_local slot s = register_thread();
+        return s;
+      }
+
+      slot register_thread() {
+        std::lock_guard lock(m_mutex);
+        m_buffers.push_back(std::make_shared<buffer>());
+        return {m_buffers.back(), static_cast<uint16_t>(m_buffers.size() - 1)};
+      }
+
+      void run() {
+        std::unique_lock lock(m_wake_mutex);
+        while (!m_stopping) {
+          m_wake.wait_for(lock, m_interval);
+
+          lock.unlock();
+          flush();
+          lock.lock();
+        }
+      }
+  };
+
+
+  sink& logger() {
+    static sink s;
+    return s;
+  }
+
+
+  template <level L, typename... Args>
+  void write(fmt::format_string<Args...> format, Args&&... args) {
+    if constexpr (L >= compiled_level && L != level::off) {
+      auto& s = logger();
+      if (L < s.threshold()) {
+        return;
+      }
+
+      record r;
+      r.time = clock::now();
+      r.severity = L;
+      r.thread = s.thread_index();
+
+      auto result = fmt::format_to_n(r.text, sizeof(r.text), format, std::forward<Args>(args)...);
+      r.length = static_cast<uint16_t>(std::min(result.size, sizeof(r.text)));
+
+      s.submit(r);
+    }
+  }
+
+  template <typename... Args>
+  void trace(fmt::format_string<Args...> format, Args&&... args) {
+    write<level::trace>(format, std::forward<Args>(args)...);
+  }
+
+  template <typename... Args>
+  void debug(fmt::format_string<Args...> format, Args&&... args) {
+    write<level::debug>(format, std::forward<Args>(args)...);
+  }
+
+  template <typename... Args>
+  void info(fmt::format_string<Args...> format, Args&&... args) {
+    write<level::info>(format, std::forward<Args>(args)...);
+  }
+
+  template <typename... Args>
+  void warn(fmt::format_string<Args...> format, Args&&... args) {
+    write<level::warn>(format, std::forward<Args>(args)...);
+  }
+
+  template <typename... Args>
+  void error(fmt::format_string<Args...> format, Args&&... args) {
+    write<level::error>(format, std::forward<Args>(args)...);
+  }
+
+
+}
@@ -0,0 +1,246 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+
+#include <SDL2/SDL.h>
+#include <SDL2/SDL_ttf.h>
+
+#include "frame.h"
+#include "geometry.h"
+#include "text.h"
+
+
+namespace isolinear::text {
+
+
+  using surface = std::shared_ptr<SDL_Surface>;
+
+
+  // Rasterises text on a worker thread so draw() never waits on FreeType.
+  //
+  // The worker opens faces of its own from the font manager's mappings.
+  // Finished surfaces are handed back through the deferred frame queue,
+  // so callbacks run on the UI thread, which only has to upload them. A
+  // newer request from the same owner replaces one still queued.
+  class rasteriser {
+    protected:
+      struct job {
+        const void* owner;
+        std::string path;
+        int size_pt;
+        theme::colour colour;
+        std::string text;
+        std::function<void(surface)> ready;
+      };
+
+      std::mutex m_mutex;
+      std::condition_variable m_wake;
+      std::condition_variable m_idle;
+      std::deque<job> m_jobs;
+      const void* m_current{nullptr};
+      bool m_stopping{false};
+
+      std::map<std::pair<std::string, int>, face> m_faces; // Worker thread only
+      std::thread m_thread;
+
+    public:
+      rasteriser() {
+        // Constructed first so they outlive the worker at exit.
+        fonts();
+        frame::deferred();
+
+        m_thread = std::thread([this]() { run(); });
+      }
+
+      rasteriser(const rasteriser&) = delete;
+      rasteriser& operator=(const rasteriser&) = delete;
+
+      ~rasteriser() {
+        {
+          std::lock_guard lock(m_mutex);
+          m_stopping = true;
+        }
+        m_wake.notify_one();
+        m_thread.join();
+      }
+
+      void submit(const void* owner, const font& f, theme::colour c, std::string t, std::function<void(surface)> ready) {
+        {
+          std::lock_guard lock(m_mutex);
+          std::erase_if(m_jobs, [owner](job const& j) { return j.owner == owner; });
+          m_jobs.push_back({owner, f.file(), f.point_size(), c, std::move(t), std::move(ready)});
+        }
+        m_wake.notify_one();
+      }
+
+      // Withdraws queued and delivered-but-unrun work. Waits out a job the
+      // worker is rendering for this owner, so nothing arrives afterwards.
+      void cancel(const void* owner) {
+        {
+          std::unique_lock lock(m_mutex);
+          std::erase_if(m_jobs, [owner](job const& j) { return j.owner == owner; });
+          m_idle.wait(lock, [this, owner]() { return m_current != owner; });
+        }
+        frame::deferred().cancel(owner);
+      }
+
+    protected:
+      void run() {
+        while (true) {
+          job j;
+
+          {
+            std::unique_lock lock(m_mutex);
+            m_wake.wait(lock, [this]() { return m_stopping || !m_jobs.empty(); });
+            if (m_stopping) {
+              return;
+            }
+
+            j = std::move(m_jobs.front());
+            m_jobs.pop_front();
+            m_current = j.owner;
+          }
+
+          surface s = render(j);
+          frame::deferred().push(j.owner, [ready = std::move(j.ready), s]() { ready(s); });
+
+          {
+            std::lock_guard lock(m_mutex);
+            m_current = nullptr;
+          }
+          m_idle.notify_all();
+        }
+      }
+
+      surface render(job const& j) {
+        if (j.text.empty()) {
+          return nullptr;
+        }
+
+        auto& f = m_faces[{j.path, j.size_pt}];
+        if (!f) {
+          f = fonts().acquire_private(j.path, j.size_pt);
+        }
+
+        uint8_t r = j.colour,
+                g = j.colour >> 8,
+                b = j.colour >> 16;
+
+        SDL_Surface* s = TTF_RenderUTF8_Blended(f.get(), j.text.c_str(), SDL_Color{r,g,b});
+        return surface(s, SDL_FreeSurface);
+      }
+  };
+
+
+  rasteriser& worker() {
+    static rasteriser r;
+    return r;
+  }
+
+
+  // Text drawn from a surface prepared by the worker.
+  //
+  // update() is cheap when nothing changed; otherwise it queues a new
+  // rasterisation and draw() carries on showing the previous text until
+  // the new surface arrives.
+  class prepared_text {
+    protected:
+      const font* m_font{nullptr};
+      theme::colour m_colour{0};
+      std::string m_text;
+      uint64_t m_generation{0};
+
+      bool m_arrived{false};
+      surface m_pending;
+
+      SDL_Texture* m_texture{nullptr};
+      geometry::vector m_size{0, 0};
+
+    public:
+      prepared_text() = default;
+
+      prepared_text(const prepared_text&) = delete;
+      prepared_text& operator=(const prepared_text&) = delete;
+
+      ~prepared_text() {
+        if (m_generation > 0) {
+          worker().cancel(this);
+        }
+        if (m_texture) {
+          SDL_DestroyTexture(m_texture);
+        }
+      }
+
+      void update(const font& f, theme::colour c, const std::string& t) {
+        if (m_generation > 0 && m_font == &f && m_colour == c && m_text == t) {
+          return;
+        }
+
+        m_font = &f;
+        m_colour = c;
+        m_text = t;
+
+        uint64_t generation = ++m_generation;
+        worker().submit(this, f, c, t, [this, generation](surface s) {
+          if (generation != m_generation) {
+            return; // Superseded while in flight
+          }
+          m_arrived = true;
+          m_pending = std::move(s);
+        });
+      }
+
+      // Size of the text currently on screen.
+      geometry::vector size() const {
+        return m_size;
+      }
+
+      void draw(SDL_Renderer* renderer, compass alignment, region bounds) {
+        if (m_arrived) {
+          upload(renderer);
+        }
+
+        if (!m_texture) {
+          return;
+        }
+
+        region label_region = bounds.align(alignment, m_size);
+        SDL_Rect label_rect{
+            label_region.X(),
+            label_region.Y(),
+            label_region.W(),
+            label_region.H()
+          };
+        SDL_RenderCopy(renderer, m_texture, NULL, &label_rect);
+      }
+
+    protected:
+      void upload(SDL_Renderer* renderer) {
+        if (m_texture) {
+          SDL_DestroyTexture(m_texture);
+          m_texture = nullptr;
+        }
+        m_size = geometry::vector{0, 0};
+
+        if (m_pending) {
+          m_texture = SDL_CreateTextureFromSurface(renderer, m_pending.get());
+          SDL_SetTextureBlendMode(m_texture, SDL_BLENDMODE_BLEND);
+          m_size = geometry::vector{m_pending->w, m_pending->h};
+        }
+
+        m_pending.reset();
+        m_arrived = false;
+      }
+  };
+
+
+}
@@ -0,0 +1,276 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <list>
+#include <memory_resource>
+#include <unordered_map>
+#include <vector>
+
+#include <SDL2/SDL.h>
+
+#include "control.h"
+#include "event.h"
+#include "frame.h"
+#include "geometry.h"
+
+
+namespace isolinear::ui {
+
+
+  // Flattened, pre-ordered view of a window's control trees.
+  //
+  // Per-control state is kept in parallel arrays so draw, hit-test and
+  // event passes are linear scans. The flat order is only rebuilt when a
+  // root's tree_version() moves on.
+  //
+  // Controls are marked DIRTY when they receive an event, are animated or
+  // report needs_redraw(). Nothing is drawn until one is, and then the
+  // whole window is repainted, as SDL leaves the back buffer undefined
+  // after a present. Bounds are re-read for every dirty control, so hit
+  // tests follow controls that move.
+  //
+  // A control pressed by the mouse or a finger captures that pointer: it
+  // keeps receiving its events, wherever they happen, up to and including
+  // the release.
+  class registry {
+    public:
+      enum flags : uint8_t {
+        DIRTY = 1 << 0,
+        HOVER = 1 << 1,
+      };
+
+      struct box {
+        int near_x, near_y, far_x, far_y;
+
+        bool encloses(geometry::vector p) const {
+          return near_x <= p.x && near_y <= p.y
+              && p.x <= far_x  && p.y <= far_y;
+        }
+      };
+
+    protected:
+      std::vector<control*> m_controls;
+      std::vector<box> m_bounds;
+      std::vector<int> m_z_order;
+      std::vector<uint8_t> m_flags;
+      std::unordered_map<control const*, std::size_t> m_index;
+
+      struct capture {
+        event::pointer_type type;
+        SDL_FingerID finger;
+        control const* c;
+
+        bool matches(event::pointer const& e) const {
+          return e.type() == type && (type == event::MOUSE || e.finger_id() == finger);
+        }
+      };
+      std::vector<capture> m_captures;
+
+      bool m_built{false};
+      unsigned m_built_version{0};
+
+      static unsigned version_of(const std::list<control*>& roots) {
+        auto v = static_cast<unsigned>(roots.size());
+        for (auto const* root : roots) {
+          v += root->tree_version();
+        }
+        return v;
+      }
+
+      void refresh_bounds(std::size_t i) {
+        geometry::region r = m_controls[i]->bounds();
+        m_bounds[i] = {r.near_x(), r.near_y(), r.far_x(), r.far_y()};
+      }
+
+    public:
+      bool stale(const std::list<control*>& roots) const {
+        return !m_built || m_built_version != version_of(roots);
+      }
+
+      void rebuild(const std::list<control*>& roots) {
+        struct node {
+          control* c;
+          int z;
+          std::size_t order;
+        };
+
+        std::pmr::vector<node> nodes(frame::scratch().resource());
+        nodes.reserve(m_controls.size());
+
+        std::pmr::vector<control*> stack(roots.rbegin(), roots.rend(), frame::scratch().resource());
+        while (!stack.empty()) {
+          control* c = stack.back();
+          stack.pop_back();
+
+          nodes.push_back({c, c->z_order(), nodes.size()});
+
+          auto const& children = c->children();
+          stack.insert(stack.end(), children.rbegin(), children.rend());
+        }
+
+        std::stable_sort(nodes.begin(), nodes.end(), [](node const& a, node const& b) {
+          return a.z < b.z;
+        });
+
+        m_controls.clear();
+        m_bounds.clear();
+        m_z_order.clear();
+        m_flags.clear();
+        m_index.clear();
+
+        for (auto const& n : nodes) {
+          geometry::region r = n.c->bounds();
+          m_index.emplace(n.c, m_controls.size());
+          m_controls.push_back(n.c);
+          m_bounds.push_back({r.near_x(), r.near_y(), r.far_x(), r.far_y()});
+          m_z_order.push_back(n.z);
+          m_flags.push_back(DIRTY | (n.c->pointer_is_hovering() ? HOVER : 0));
+        }
+
+        std::erase_if(m_captures, [this](capture const& k) { return !m_index.contains(k.c); });
+
+        m_built = true;
+        m_built_version = version_of(roots);
+      }
+
+      // After a relayout, e.g. when the window is resized.
+      void refresh_bounds() {
+        for (std::size_t i = 0; i < m_controls.size(); i++) {
+          refresh_bounds(i);
+          m_flags[i] |= DIRTY;
+        }
+      }
+
+      std::size_t size() const {
+        return m_controls.size();
+      }
+
+      // Picks up controls that asked for a repaint since the last frame;
+      // true if anything needs drawing.
+      bool collect() {
+        bool dirty = false;
+        for (std::size_t i = 0; i < m_controls.size(); i++) {
+          if (m_controls[i]->needs_redraw()) {
+            m_flags[i] |= DIRTY;
+          }
+          if (m_flags[i] & DIRTY) {
+            refresh_bounds(i);
+            dirty = true;
+          }
+        }
+        return dirty;
+      }
+
+      void draw(SDL_Renderer* renderer) {
+        for (std::size_t i = 0; i < m_controls.size(); i++) {
+          m_controls[i]->draw(renderer);
+          m_controls[i]->drawn();
+          m_flags[i] &= ~DIRTY;
+        }
+      }
+
+      // Topmost control under the point, or nullptr.
+      control* hit_test(geometry::position p) const {
+        for (std::size_t i = m_controls.size(); i-- > 0;) {
+          if (m_bounds[i].encloses(p)) {
+            return m_controls[i];
+          }
+        }
+        return nullptr;
+      }
+
+      // Only controls under the pointer, that were under it last time (so
+      // they see the leave), or that captured it receive the event.
+      void dispatch(event::pointer event) {
+        geometry::position p = event.position();
+        bool press = event.is_mouse_down() || event.is_finger_down();
+        bool release = event.is_mouse_up() || event.is_finger_up();
+
+        for (std::size_t i = 0; i < m_controls.size(); i++) {
+          bool within = m_bounds[i].encloses(p);
+          bool was_hovering = m_flags[i] & HOVER;
+          if (!within && !was_hovering && !captured(event, m_controls[i])) {
+            continue;
+          }
+
+          m_controls[i]->on_pointer_event(event);
+
+          if (press && within) {
+            m_captures.push_back({event.type(), event.finger_id(), m_controls[i]});
+          }
+
+          bool hovering = within || m_controls[i]->pointer_is_hovering();
+          m_flags[i] = hovering
+                     ? (m_flags[i] | HOVER | DIRTY)
+                     : ((m_flags[i] & ~HOVER) | DIRTY);
+        }
+
+        if (release) {
+          std::erase_if(m_captures, [&event](capture const& k) { return k.matches(event); });
+        }
+      }
+
+      bool captured(event::pointer const& event, control const* c) const {
+        return std::any_of(m_captures.begin(), m_captures.end(), [&](capture const& k) {
+          return k.c == c && k.matches(event);
+        });
+      }
+
+      void dispatch(event::keyboard event) {
+        for (std::size_t i = 0; i < m_controls.size(); i++) {
+          m_controls[i]->on_keyboard_event(event);
+          m_flags[i] |= DIRTY;
+        }
+      }
+
+      // Only the topmost control under the pointer scrolls.
+      void dispatch(event::wheel event) {
+        if (auto* c = hit_test(event.position())) {
+          c->on_wheel_event(event);
+          mark_dirty(c);
+        }
+      }
+
+      void dispatch(event::gesture event) {
+        for (std::size_t i = 0; i < m_controls.size(); i++) {
+          m_controls[i]->on_gesture_event(event);
+          m_flags[i] |= DIRTY;
+        }
+      }
+
+      // Controls drawn by a parent outside the registry dirty that parent.
+      void mark_dirty(control const* c) {
+        for (; c; c = c->parent()) {
+          auto it = m_index.find(c);
+          if (it != m_index.end()) {
+            m_flags[it->second] |= DIRTY;
+            return;
+          }
+        }
+      }
+
+      bool any_dirty() const {
+        for (auto f : m_flags) {
+          if (f & DIRTY) {
+            return true;
+          }
+        }
+        return false;
+      }
+
+      bool is_hovered(std::size_t i) const {
+        return m_flags[i] & HOVER;
+      }
+
+      int z_order(std::size_t i) const {
+        return m_z_order[i];
+      }
+
+      control* at(std::size_t i) const {
+        return m_controls[i];
+      }
+  };
+
+
+}
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+
+
+namespace isolinear {
+
+
+  // Lock-free single-producer, single-consumer ring buffer.
+  //
+  // One thread pushes, one thread drains. Capacity must be a power of two;
+  // pushes into a full ring are dropped and reported by returning false.
+  template <typename T, std::size_t Capacity>
+  class spsc_ring {
+      static_assert((Capacity & (Capacity - 1)) == 0, "spsc_ring capacity must be a power of two");
+      static constexpr std::size_t mask = Capacity - 1;
+
+    protected:
+      std::array<T, Capacity> m_buffer{};
+      alignas(64) std::atomic<std::size_t> m_head{0}; // Written by the producer
+      alignas(64) std::atomic<std::size_t> m_tail{0}; // Written by the consumer
+
+    public:
+      bool push(const T& value) {
+        std::size_t head = m_head.load(std::memory_order_relaxed);
+        std::size_t tail = m_tail.load(std::memory_order_acquire);
+        if (head - tail == Capacity) {
+          return false;
+        }
+
+        m_buffer[head & mask] = value;
+        m_head.store(head + 1, std::memory_order_release);
+        return true;
+      }
+
+      // Hands every queued element to f, oldest first; returns how many.
+      template <typename F>
+      std::size_t drain(F&& f) {
+        std::size_t tail = m_tail.load(std::memory_order_relaxed);
+        std::size_t head = m_head.load(std::memory_order_acquire);
+
+        for (std::size_t i = tail; i != head; ++i) {
+          f(m_buffer[i & mask]);
+        }
+
+        m_tail.store(head, std::memory_order_release);
+        return head - tail;
+      }
+
+      std::size_t size() const {
+        return m_head.load(std::memory_order_acquire)
+             - m_tail.load(std::memory_order_acquire);
+      }
+
+      static constexpr std::size_t capacity() {
+        return Capacity;
+      }
+  };
+
+
+}
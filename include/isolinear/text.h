@@ -1,5 +1,21 @@
 #pragma once
 
+#include <array>
+#include <cstdint>
+#include <cstdlib>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <utility>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
 #include <SDL2/SDL.h>
 #include <SDL2/SDL_ttf.h>
 #include <SDL2/SDL2_gfxPrimitives.h>
@@ -13,6 +29,146 @@ namespace isolinear::text {
   using isolinear::compass;
 
 
+  // A font file mapped read-only into memory for as long as any face
+  // opened from it is alive.
+  class font_file {
+    protected:
+      std::string m_path;
+      void* m_data{MAP_FAILED};
+      std::size_t m_size{0};
+
+    public:
+      explicit font_file(std::string path)
+        : m_path{std::move(path)}
+      {
+        int fd = ::open(m_path.c_str(), O_RDONLY);
+        if (fd < 0) {
+          throw std::runtime_error("Failed to open font file: " + m_path);
+        }
+
+        struct stat st{};
+        if (::fstat(fd, &st) == 0 && st.st_size > 0) {
+          m_size = st.st_size;
+          m_data = ::mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        }
+        ::close(fd);
+
+        if (m_data == MAP_FAILED) {
+          throw std::runtime_error("Failed to map font file: " + m_path);
+        }
+      }
+
+      font_file(const font_file&) = delete;
+      font_file& operator=(const font_file&) = delete;
+
+      ~font_file() {
+        ::munmap(m_data, m_size);
+      }
+
+      const std::string& path() const { return m_path; }
+      const void* data() const { return m_data; }
+      std::size_t size() const { return m_size; }
+  };
+
+
+  using face = std::shared_ptr<TTF_Font>;
+
+
+  // Process-wide cache of font files and the faces opened from them.
+  //
+  // Each file is mapped once and every point size is opened from that
+  // mapping through SDL_RWFromConstMem. Faces are refcounted: windows
+  // asking for the same (path, size) share one TTF_Font, and the file is
+  // unmapped when its last face closes. Faces are opened and closed under
+  // the manager's lock, as FreeType needs for faces of one library, from
+  // whichever thread drops the last reference.
+  class font_manager {
+    protected:
+      std::mutex m_mutex;
+      std::string m_default_path;
+      std::map<std::string, std::weak_ptr<font_file>> m_files;
+      std::map<std::pair<std::string, int>, std::weak_ptr<TTF_Font>> m_faces;
+
+    public:
+      font_manager() {
+        const char* env = std::getenv("ISOLINEAR_FONT");
+        m_default_path = env
+                       ? env
+                       : "/home/daniel/.fonts/Swiss 911 Ultra Compressed Regular.otf";
+      }
+
+      // Path used by fonts constructed without one. Only affects fonts
+      // that have not been loaded yet.
+      void default_path(std::string path) {
+        std::lock_guard lock(m_mutex);
+        m_default_path = std::move(path);
+      }
+
+      std::string default_path() {
+        std::lock_guard lock(m_mutex);
+        return m_default_path;
+      }
+
+      // Shared face for (path, size), opened on first request.
+      face acquire(const std::string& path, int size_pt) {
+        std::lock_guard lock(m_mutex);
+
+        auto& cached = m_faces[{path, size_pt}];
+        if (auto f = cached.lock()) {
+          return f;
+        }
+
+        face f = open_face(path, size_pt);
+        cached = f;
+        return f;
+      }
+
+      // Face of its own on the shared mapping, for use off the UI thread.
+      face acquire_private(const std::string& path, int size_pt) {
+        std::lock_guard lock(m_mutex);
+        return open_face(path, size_pt);
+      }
+
+    protected:
+      void release(TTF_Font* f) {
+        std::lock_guard lock(m_mutex);
+        TTF_CloseFont(f);
+      }
+
+      std::shared_ptr<font_file> map_file(const std::string& path) {
+        auto& cached = m_files[path];
+        if (auto file = cached.lock()) {
+          return file;
+        }
+
+        auto file = std::make_shared<font_file>(path);
+        cached = file;
+        return file;
+      }
+
+      face open_face(const std::string& path, int size_pt) {
+        auto file = map_file(path);
+
+        SDL_RWops* rw = SDL_RWFromConstMem(file->data(), static_cast<int>(file->size()));
+        TTF_Font* f = rw ? TTF_OpenFontRW(rw, 1, size_pt) : nullptr;
+
+        if (!f) {
+          fprintf(stderr, "Couldn't load font: %s\n", TTF_GetError());
+          throw std::runtime_error("Failed to load font");
+        }
+
+        // The face reads from the mapping, so it holds the file open.
+        return face(f, [this, file](TTF_Font* f) { release(f); });
+      }
+  };
+
+
+  font_manager& fonts() {
+    static font_manager manager;
+    return manager;
+  }
+
+
   class rendered_text {
     protected:
       TTF_Font* m_sdl_font;
@@ -60,31 +216,124 @@ namespace isolinear::text {
   class font {
 
   protected:
-      std::string path;
+      mutable std::string path;
       int size_pt;
       theme::colour colour;
-      TTF_Font* sdl_font;
+      mutable face sdl_font;
+
+      // Printable ASCII advances, -1 for missing glyphs; filled on first use.
+      static constexpr std::size_t max_extents = 1024;
+      mutable std::array<int, 128> m_advances{};
+      mutable bool m_advances_loaded{false};
+      mutable std::unordered_map<std::string, geometry::vector> m_extents;
 
     public:
       font(std::string p, int s, theme::colour c)
           : path{p}, size_pt{s}, colour{c}
-      {
-        sdl_font = TTF_OpenFont(path.c_str(), size_pt);
+      {};
 
+      // Uses the font manager's default path, resolved on first use.
+      font(int s, theme::colour c)
+          : font("", s, c)
+      {};
+
+      // Opens (or shares) the face the first time it is needed.
+      TTF_Font* handle() const {
         if (!sdl_font) {
-          fprintf(stderr, "Couldn't load font: %s\n", TTF_GetError());
-          throw std::runtime_error(
-            "Failed to load font"
-          );
+          sdl_font = fonts().acquire(file(), size_pt);
         }
-      };
+        return sdl_font.get();
+      }
+
+      const std::string& file() const {
+        if (path.empty()) {
+          path = fonts().default_path();
+        }
+        return path;
+      }
+
+      int point_size() const {
+        return size_pt;
+      }
 
-      ~font() {
-        TTF_CloseFont(sdl_font);
+      theme::colour text_colour() const {
+        return colour;
+      }
+
+    protected:
+      void load_advances() const {
+        if (m_advances_loaded) {
+          return;
+        }
+
+        TTF_Font* f = handle();
+        for (int c = 0; c < static_cast<int>(m_advances.size()); c++) {
+          int adv = 0;
+          if (c < ' ' || c > '~' || TTF_GlyphMetrics(f, c, nullptr, nullptr, nullptr, nullptr, &adv) != 0) {
+            adv = -1;
+          }
+          m_advances[c] = adv;
+        }
+        m_advances_loaded = true;
       }
 
+      geometry::vector layout_extent(const std::string& text) const {
+        load_advances();
+
+        TTF_Font* f = handle();
+        int width = 0;
+        Uint16 previous = 0;
+
+        for (unsigned char c : text) {
+          if (c >= m_advances.size() || m_advances[c] < 0) {
+            int w = 0, h = 0;
+            TTF_SizeUTF8(f, text.c_str(), &w, &h);
+            return geometry::vector{w, h};
+          }
+
+          if (previous) {
+            width += TTF_GetFontKerningSizeGlyphs(f, previous, c);
+          }
+          width += m_advances[c];
+          previous = c;
+        }
+
+        return geometry::vector{width, height()};
+      }
+
+    public:
+
       int height() const {
-        return TTF_FontHeight(sdl_font);
+        return TTF_FontHeight(handle());
+      }
+
+      // Horizontal advance of a printable ASCII character, 0 otherwise.
+      int advance(char c) const {
+        load_advances();
+        auto i = static_cast<unsigned char>(c);
+        return (i < m_advances.size() && m_advances[i] > 0) ? m_advances[i] : 0;
+      }
+
+      // Size the text would render at, without rendering it.
+      //
+      // Results are memoised per string. Printable ASCII is summed from
+      // the advance table plus kerning; anything else goes through
+      // TTF_SizeUTF8.
+      geometry::vector measure(const std::string& text) const {
+        auto it = m_extents.find(text);
+        if (it != m_extents.end()) {
+          return it->second;
+        }
+
+        if (m_extents.size() >= max_extents) {
+          m_extents.clear();
+        }
+
+        geometry::vector extent = text.empty()
+                                ? geometry::vector{0, height()}
+                                : layout_extent(text);
+        m_extents.emplace(text, extent);
+        return extent;
       }
 
       void render_text(
@@ -98,7 +347,7 @@ namespace isolinear::text {
                 b = colour >> 16;
 
         SDL_Surface* surface = TTF_RenderUTF8_Blended(
-            sdl_font, text.c_str(), SDL_Color{r,g,b}
+            handle(), text.c_str(), SDL_Color{r,g,b}
         );
 
         SDL_Texture* texture = SDL_CreateTextureFromSurface(
@@ -120,7 +369,16 @@ namespace isolinear::text {
       };
 
       rendered_text render_text(theme::colour colour, std::string text) const {
-        return rendered_text{sdl_font, colour, text};
+        return rendered_text{handle(), colour, text};
+      }
+
+      // Rasterises to an ARGB8888 surface the caller frees; nullptr for empty text.
+      SDL_Surface* render_surface(theme::colour colour, const std::string& text) const {
+        uint8_t r = colour,
+                g = colour >> 8,
+                b = colour >> 16;
+
+        return TTF_RenderUTF8_Blended(handle(), text.c_str(), SDL_Color{r,g,b});
       }
   };
 
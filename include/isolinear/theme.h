@@ -1,5 +1,7 @@
 #pragma once
 
+#include <memory>
+
 namespace isolinear::theme {
 
 
@@ -73,4 +75,39 @@ namespace isolinear::theme {
     };
 
 
+  // A colour scheme shared by reference between a window and its controls.
+  // Replacing the scheme is O(1) however many controls use it; the version
+  // lets controls notice the change and refresh anything they cache.
+  class palette {
+    protected:
+      colour_scheme m_scheme;
+      unsigned m_version{0};
+
+    public:
+      palette() = default;
+
+      explicit palette(colour_scheme cs)
+        : m_scheme{cs} {}
+
+      const colour_scheme& scheme() const {
+        return m_scheme;
+      }
+
+      void scheme(const colour_scheme& cs) {
+        m_scheme = cs;
+        ++m_version;
+      }
+
+      unsigned version() const {
+        return m_version;
+      }
+  };
+
+
+  std::shared_ptr<palette> const& global_palette() {
+    static std::shared_ptr<palette> p = std::make_shared<palette>(nightgazer_colours);
+    return p;
+  }
+
+
 }
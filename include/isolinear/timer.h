@@ -1,12 +1,359 @@
 #pragma once
 
+#include <array>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include <asio.hpp>
+#include <miso.h>
+
 namespace isolinear {
 
+  // Hierarchical timing wheel multiplexing any number of timers onto a
+  // single asio::steady_timer.
+  //
+  // Four levels of 256 slots cover 2^32 ticks of `resolution` each. Timers
+  // are kept on steady_clock and periodic timers are re-armed from their
+  // previous deadline rather than from "now", so they do not drift. Expired
+  // callbacks run on the io_context's thread.
+  //
+  // Callbacks run outside the lock. cancel() waits out a callback that is
+  // already running for the handle, so once it returns the callback will
+  // not run again and anything it uses can be destroyed. Cancelling from
+  // inside a callback does not wait.
+  class timing_wheel {
+    public:
+      using clock = std::chrono::steady_clock;
+      using handle = uint64_t;
+
+      // What a periodic timer does when it wakes more than a period late.
+      enum catch_up {
+        FIRE_ALL,    // Invoke once for every period that was missed
+        SKIP_MISSED  // Invoke once and carry on from the next future period
+      };
+
+    protected:
+      static constexpr unsigned level_bits = 8;
+      static constexpr unsigned slots = 1u << level_bits;
+      static constexpr unsigned levels = 4;
+
+      struct entry {
+        uint64_t tick;
+        clock::time_point deadline;
+        clock::duration period;
+        catch_up policy;
+        std::shared_ptr<std::function<void()>> callback;
+      };
+
+      struct due {
+        handle h;
+        std::shared_ptr<std::function<void()>> callback;
+        unsigned times;
+      };
+
+      // One-shot entries stay in m_entries at this tick until their
+      // callback has run, so cancel() can still find them.
+      static constexpr uint64_t fired_tick = ~uint64_t{0};
+
+      asio::io_context& m_io_context;
+      asio::steady_timer m_asio_timer;
+      clock::duration m_resolution;
+      clock::time_point m_epoch;
+      uint64_t m_cursor{0};
+      bool m_armed{false};
+      uint64_t m_armed_tick{0};
+
+      std::array<std::array<std::vector<handle>, slots>, levels> m_wheel;
+      std::unordered_map<handle, entry> m_entries;
+      handle m_next_handle{1};
+      std::mutex m_mutex;
+
+      handle m_running{0}; // Callback being invoked by poll()
+      std::thread::id m_polling;
+      std::condition_variable m_ran;
+
+    public:
+      timing_wheel(asio::io_context& ioc, clock::duration resolution = std::chrono::milliseconds(10))
+        : m_io_context(ioc)
+        , m_asio_timer(ioc)
+        , m_resolution(resolution)
+        , m_epoch(clock::now())
+      {}
+
+      timing_wheel(const timing_wheel&) = delete;
+      timing_wheel& operator=(const timing_wheel&) = delete;
+
+      // One wheel per io_context, created on first use.
+      static timing_wheel& of(asio::io_context& ioc) {
+        static std::mutex mutex;
+        static std::map<asio::io_context*, std::unique_ptr<timing_wheel>> wheels;
+
+        std::lock_guard lock(mutex);
+        auto& wheel = wheels[&ioc];
+        if (!wheel) {
+          wheel = std::make_unique<timing_wheel>(ioc);
+        }
+        return *wheel;
+      }
+
+      clock::duration resolution() const {
+        return m_resolution;
+      }
+
+      handle schedule(clock::duration delay, std::function<void()> callback) {
+        return insert(clock::now() + delay, clock::duration::zero(), SKIP_MISSED, std::move(callback));
+      }
+
+      handle schedule_periodic(
+          clock::duration period,
+          std::function<void()> callback,
+          catch_up policy = FIRE_ALL
+      ) {
+        return insert(clock::now() + period, period, policy, std::move(callback));
+      }
+
+      bool cancel(handle h) {
+        std::unique_lock lock(m_mutex);
+        bool erased = m_entries.erase(h) > 0;
+        if (std::this_thread::get_id() != m_polling) {
+          m_ran.wait(lock, [this, h]() { return m_running != h; });
+        }
+        return erased;
+      }
+
+      std::size_t size() {
+        std::lock_guard lock(m_mutex);
+        return m_entries.size();
+      }
+
+      // Fires everything due at `now`. Called from the asio wait handler, but
+      // usable directly when driving the wheel by hand.
+      void poll(clock::time_point now) {
+        std::vector<due> fired;
+
+        {
+          std::lock_guard lock(m_mutex);
+          m_polling = std::this_thread::get_id();
+          uint64_t target = to_tick_floor(now);
+          while (m_cursor < target) {
+            ++m_cursor;
+            cascade();
+            collect(now, fired);
+          }
+        }
+
+        for (auto& d : fired) {
+          for (unsigned i = 0; i < d.times; i++) {
+            {
+              std::lock_guard lock(m_mutex);
+              if (!m_entries.contains(d.h)) {
+                break; // Cancelled since it was collected
+              }
+              m_running = d.h;
+            }
+
+            (*d.callback)();
+
+            {
+              std::lock_guard lock(m_mutex);
+              m_running = 0;
+              auto it = m_entries.find(d.h);
+              if (it != m_entries.end() && it->second.tick == fired_tick) {
+                m_entries.erase(it);
+              }
+            }
+            m_ran.notify_all();
+          }
+        }
+
+        std::lock_guard lock(m_mutex);
+        m_polling = {};
+      }
+
+    protected:
+      handle insert(clock::time_point deadline, clock::duration period, catch_up policy, std::function<void()> callback) {
+        handle h;
+
+        {
+          std::lock_guard lock(m_mutex);
+
+          if (m_entries.empty()) {
+            // Nothing pending: jump the cursor instead of stepping through idle ticks.
+            for (auto& level : m_wheel) {
+              for (auto& slot : level) {
+                slot.clear();
+              }
+            }
+            m_cursor = to_tick_floor(clock::now());
+          }
+
+          h = m_next_handle++;
+          uint64_t tick = std::max(to_tick_ceil(deadline), m_cursor + 1);
+          m_entries.emplace(h, entry{
+              tick, deadline, period, policy,
+              std::make_shared<std::function<void()>>(std::move(callback))
+          });
+          place(h, tick);
+        }
+
+        asio::post(m_io_context, [this]() { rearm(); });
+        return h;
+      }
+
+      uint64_t to_tick_floor(clock::time_point t) const {
+        if (t <= m_epoch) {
+          return 0;
+        }
+        return (t - m_epoch) / m_resolution;
+      }
+
+      uint64_t to_tick_ceil(clock::time_point t) const {
+        if (t <= m_epoch) {
+          return 0;
+        }
+        return ((t - m_epoch) + m_resolution - clock::duration{1}) / m_resolution;
+      }
+
+      void place(handle h, uint64_t tick) {
+        uint64_t delta = (tick > m_cursor) ? tick - m_cursor : 0;
+
+        unsigned level = 0;
+        while (level < levels - 1 && delta >= (uint64_t{1} << (level_bits * (level + 1)))) {
+          level++;
+        }
+
+        uint64_t max_delta = (uint64_t{1} << (level_bits * levels)) - 1;
+        if (delta > max_delta) {
+          tick = m_cursor + max_delta; // Re-placed with its real tick on cascade
+        }
+
+        auto slot = (tick >> (level_bits * level)) & (slots - 1);
+        m_wheel[level][slot].push_back(h);
+      }
+
+      // Moves entries from higher levels down as the cursor crosses their boundary.
+      void cascade() {
+        for (unsigned level = levels - 1; level > 0; level--) {
+          uint64_t mask = (uint64_t{1} << (level_bits * level)) - 1;
+          if ((m_cursor & mask) != 0) {
+            continue;
+          }
+
+          auto& slot = m_wheel[level][(m_cursor >> (level_bits * level)) & (slots - 1)];
+          std::vector<handle> moving;
+          moving.swap(slot);
+
+          for (handle h : moving) {
+            auto it = m_entries.find(h);
+            if (it != m_entries.end()) {
+              place(h, it->second.tick);
+            }
+          }
+        }
+      }
+
+      void collect(clock::time_point now, std::vector<due>& fired) {
+        auto& slot = m_wheel[0][m_cursor & (slots - 1)];
+        std::vector<handle> current;
+        current.swap(slot);
+
+        for (handle h : current) {
+          auto it = m_entries.find(h);
+          if (it == m_entries.end()) {
+            continue; // Cancelled
+          }
+
+          entry& e = it->second;
+          if (e.tick > m_cursor) {
+            place(h, e.tick);
+            continue;
+          }
+
+          if (e.period == clock::duration::zero()) {
+            fired.push_back({h, e.callback, 1});
+            e.tick = fired_tick;
+            continue;
+          }
+
+          // Drift-free: the next deadline follows from the last one, not from now.
+          unsigned missed = 0;
+          e.deadline += e.period;
+          while (e.deadline <= now) {
+            e.deadline += e.period;
+            missed++;
+          }
+
+          fired.push_back({h, e.callback, e.policy == FIRE_ALL ? missed + 1 : 1});
+          e.tick = std::max(to_tick_ceil(e.deadline), m_cursor + 1);
+          place(h, e.tick);
+        }
+      }
+
+      // Earliest tick worth waking for: the next occupied level-0 slot, or
+      // the next level-0 wrap where higher levels cascade.
+      uint64_t next_wakeup() const {
+        uint64_t boundary = (m_cursor | (slots - 1)) + 1;
+        for (uint64_t tick = m_cursor + 1; tick < boundary; tick++) {
+          if (!m_wheel[0][tick & (slots - 1)].empty()) {
+            return tick;
+          }
+        }
+        return boundary;
+      }
+
+      // Only ever called on the io_context's thread.
+      void rearm() {
+        uint64_t next;
+
+        {
+          std::lock_guard lock(m_mutex);
+          if (m_entries.empty()) {
+            m_armed = false;
+            return;
+          }
+
+          next = next_wakeup();
+          if (m_armed && m_armed_tick == next) {
+            return;
+          }
+
+          m_armed = true;
+          m_armed_tick = next;
+        }
+
+        m_asio_timer.expires_at(m_epoch + (m_resolution * next));
+        m_asio_timer.async_wait([this](std::error_code ec) {
+          if (ec) {
+            return; // Superseded by a newer rearm()
+          }
+
+          {
+            std::lock_guard lock(m_mutex);
+            m_armed = false;
+          }
+
+          poll(clock::now());
+          rearm();
+        });
+      }
+  };
+
+
   class timer {
     public:
-      asio::io_context& io_context;
-      std::chrono::time_point<std::chrono::system_clock> started;
-      asio::high_resolution_timer asio_timer;
+      timing_wheel& wheel;
+      timing_wheel::clock::time_point started;
+      timing_wheel::clock::duration interval;
+      timing_wheel::handle tick_handle{0};
       unsigned ticks_remaining = 1;
       unsigned ticks_elapsed = 0;
 
@@ -15,26 +362,43 @@ namespace isolinear {
       miso::signal<> signal_expired;
 
     public:
-      timer(asio::io_context& ioc, unsigned s)
-        : io_context(ioc)
+      timer(
+          timing_wheel& w,
+          unsigned s,
+          timing_wheel::clock::duration i = std::chrono::seconds(1)
+      )
+        : wheel(w)
+        , started(timing_wheel::clock::now())
+        , interval(i)
         , ticks_remaining(s)
-        , started(std::chrono::system_clock::now())
-        , asio_timer(ioc, std::chrono::seconds(1))
       {
-        asio_timer.async_wait(std::bind(&timer::tick_handler, this, std::placeholders::_1));
+        tick_handle = wheel.schedule_periodic(interval, [this]() { tick_handler(); });
+      }
+
+      timer(asio::io_context& ioc, unsigned s)
+        : timer(timing_wheel::of(ioc), s)
+      {}
+
+      timer(const timer&) = delete;
+      timer& operator=(const timer&) = delete;
+
+      ~timer() {
+        wheel.cancel(tick_handle);
       }
 
     protected:
-      void tick_handler(std::error_code) {
+      void tick_handler() {
+        if (ticks_remaining == 0) {
+          return;
+        }
+
         if (ticks_remaining == 1) {
+          wheel.cancel(tick_handle);
           emit signal_tick(ticks_remaining, ticks_elapsed);
           emit signal_expired();
         }
         else {
           emit signal_tick(ticks_remaining, ticks_elapsed);
-
-          asio_timer.expires_at(asio_timer.expires_at() + std::chrono::seconds(1));
-          asio_timer.async_wait(std::bind(&timer::tick_handler, this, std::placeholders::_1));
         }
 
         --ticks_remaining;
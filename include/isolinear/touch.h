@@ -0,0 +1,152 @@
+#pragma once
+
+#include <cstdlib>
+#include <vector>
+
+#include <SDL2/SDL.h>
+
+#include "compass.h"
+#include "event.h"
+#include "geometry.h"
+
+
+namespace isolinear::touch {
+
+
+  struct thresholds {
+    int slop_px{12};           // Movement tolerated before a touch stops being a tap
+    Uint32 tap_ms{300};
+    Uint32 long_press_ms{600};
+    int swipe_px{60};
+    Uint32 swipe_ms{600};
+  };
+
+
+  class tracker {
+    protected:
+      struct finger {
+        SDL_FingerID id;
+        geometry::position origin;
+        geometry::position position;
+        Uint32 started;
+        bool moved;
+        bool long_pressed;
+      };
+
+      thresholds m_thresholds;
+      std::vector<finger> m_fingers;
+
+    public:
+      explicit tracker(thresholds t = {})
+        : m_thresholds{t}
+      {
+        m_fingers.reserve(10);
+      }
+
+      std::size_t active_fingers() const {
+        return m_fingers.size();
+      }
+
+      // Feed a finger event in; any gesture it completes is passed to emit_gesture.
+      template <typename F>
+      void track(event::pointer event, F&& emit_gesture) {
+        if (event.type() != event::FINGER) {
+          return;
+        }
+
+        if (event.is_finger_down()) {
+          m_fingers.push_back({
+              event.finger_id(),
+              event.position(), event.position(),
+              event.timestamp(),
+              false, false
+            });
+          return;
+        }
+
+        auto it = find(event.finger_id());
+        if (it == m_fingers.end()) {
+          return;
+        }
+
+        it->position = event.position();
+        if (beyond(it->origin, it->position, m_thresholds.slop_px)) {
+          it->moved = true;
+        }
+
+        if (!event.is_finger_up()) {
+          return;
+        }
+
+        finger f = *it;
+        m_fingers.erase(it);
+
+        if (f.long_pressed) {
+          return;
+        }
+
+        Uint32 duration = event.timestamp() - f.started;
+
+        if (beyond(f.origin, f.position, m_thresholds.swipe_px)
+            && duration <= m_thresholds.swipe_ms) {
+          emit_gesture(event::gesture{
+              event::SWIPE, f.id, f.origin, f.position, duration,
+              direction(f.origin, f.position)
+            });
+          return;
+        }
+
+        if (!f.moved && duration <= m_thresholds.tap_ms) {
+          emit_gesture(event::gesture{
+              event::TAP, f.id, f.origin, f.position, duration
+            });
+        }
+      }
+
+      // Fires time-based gestures (long press) for fingers that are still down.
+      template <typename F>
+      void update(Uint32 now, F&& emit_gesture) {
+        for (auto& f : m_fingers) {
+          if (f.moved || f.long_pressed) {
+            continue;
+          }
+
+          Uint32 duration = now - f.started;
+          if (duration >= m_thresholds.long_press_ms) {
+            f.long_pressed = true;
+            emit_gesture(event::gesture{
+                event::LONG_PRESS, f.id, f.origin, f.position, duration
+              });
+          }
+        }
+      }
+
+    protected:
+      std::vector<finger>::iterator find(SDL_FingerID id) {
+        for (auto it = m_fingers.begin(); it != m_fingers.end(); ++it) {
+          if (it->id == id) {
+            return it;
+          }
+        }
+        return m_fingers.end();
+      }
+
+      static bool beyond(geometry::position a, geometry::position b, int px) {
+        int dx = b.x - a.x;
+        int dy = b.y - a.y;
+        return (dx * dx) + (dy * dy) > (px * px);
+      }
+
+      static compass direction(geometry::position from, geometry::position to) {
+        int dx = to.x - from.x;
+        int dy = to.y - from.y;
+
+        if (std::abs(dx) > std::abs(dy)) {
+          return (dx > 0) ? compass::east : compass::west;
+        }
+        return (dy > 0) ? compass::south : compass::north;
+      }
+  };
+
+
+}
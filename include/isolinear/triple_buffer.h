@@ -0,0 +1,65 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+
+namespace isolinear {
+
+
+  // Lock-free triple buffer between one producer and one consumer.
+  //
+  // The producer fills back() and publishes it; the consumer acquires the
+  // most recently published slot and reads front() for as long as it
+  // likes. Neither side ever waits, and the consumer always sees a whole,
+  // consistent value. Intermediate values the consumer never acquired
+  // are simply overwritten.
+  template <typename T>
+  class triple_buffer {
+      static constexpr uint8_t index_mask = 0x3;
+      static constexpr uint8_t fresh = 0x4;
+
+    protected:
+      std::array<T, 3> m_slots;
+      alignas(64) std::atomic<uint8_t> m_middle{1}; // Slot index, plus fresh when unread
+      alignas(64) uint8_t m_back{0};                 // Producer only
+      alignas(64) uint8_t m_front{2};                // Consumer only
+
+    public:
+      triple_buffer() = default;
+
+      explicit triple_buffer(const T& initial)
+        : m_slots{initial, initial, initial}
+      {}
+
+      triple_buffer(const triple_buffer&) = delete;
+      triple_buffer& operator=(const triple_buffer&) = delete;
+
+      T& back() {
+        return m_slots[m_back];
+      }
+
+      void publish() {
+        uint8_t previous = m_middle.exchange(m_back | fresh, std::memory_order_acq_rel);
+        m_back = previous & index_mask;
+      }
+
+      // Swaps in the latest published value; false if there was none.
+      bool acquire() {
+        if (!(m_middle.load(std::memory_order_relaxed) & fresh)) {
+          return false;
+        }
+
+        uint8_t previous = m_middle.exchange(m_front, std::memory_order_acq_rel);
+        m_front = previous & index_mask;
+        return true;
+      }
+
+      const T& front() const {
+        return m_slots[m_front];
+      }
+  };
+
+
+}
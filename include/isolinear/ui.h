@@ -1,8 +1,15 @@
 #pragma once
 
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <deque>
 #include <list>
-#include <map>
+#include <memory>
+#include <stdexcept>
 #include <string>
+#include <unordered_map>
+#include <vector>
 
 #include <iostream>
 #include <utility>
@@ -20,6 +27,10 @@
 #include "geometry.h"
 #include "layout.h"
 #include "event.h"
+#include "frame.h"
+#include "log.h"
+#include "rasteriser.h"
+#include "ring.h"
 
 
 namespace isolinear::ui {
@@ -29,6 +40,13 @@ namespace isolinear::ui {
     using isolinear::geometry::region;
 
 
+    // Labels are drawn with a space either side. Widgets pad once when the
+    // text is set, so draw() never builds strings.
+    std::string pad_label(const std::string &text) {
+      return " " + text + " ";
+    }
+
+
     // Widgets
 
 
@@ -80,7 +98,7 @@ namespace isolinear::ui {
               offset_px = (bound_width - gutter_space);
               break;
             default:
-              std::cout << fmt::format("Invalid alignment for horizontal_rule. alignment={}", m_alignment);
+              log::warn("Invalid alignment for vertical_rule. alignment={}", static_cast<int>(m_alignment));
               break;
           }
 
@@ -119,7 +137,7 @@ namespace isolinear::ui {
               offset_px = (bound_height - m_grid.gutter().y);
               break;
             default:
-              std::cout << fmt::format("Invalid alignment for horizontal_rule. alignment={}", m_alignment);
+              log::warn("Invalid alignment for horizontal_rule. alignment={}", static_cast<int>(m_alignment));
               break;
           }
 
@@ -144,6 +162,8 @@ namespace isolinear::ui {
         bool m_enabled = true;
         bool m_active = false;
         std::string m_label;
+        std::string m_padded_label;
+        mutable text::prepared_text m_label_text;
 
     public:
         button( const button& ) = delete; // non construction-copyable
@@ -153,31 +173,39 @@ namespace isolinear::ui {
         miso::signal<> signal_press;
 
         button(display::window &w, layout::grid g, std::string l)
-          : control(std::move(g)), m_window{w}, m_label{l} {}
+          : control(std::move(g)), m_window{w}, m_label{l}, m_padded_label{pad_label(l)} {}
 
-        void enable() { m_enabled = true; }
+        void enable() { enabled(true); }
 
-        void disable() { m_enabled = false; }
+        void disable() { enabled(false); }
 
         bool enabled() const { return m_enabled; }
 
         void enabled(const bool state) {
           m_enabled = state;
+          changed();
         }
 
         bool disabled() const { return !m_enabled; }
 
-        void activate() { m_active = true; }
+        void activate() { active(true); }
 
-        void deactivate() { m_active = false; }
+        void deactivate() { active(false); }
 
-        void active(bool state) { m_active = state; }
+        void active(bool state) {
+          m_active = state;
+          changed();
+        }
 
         [[nodiscard]] bool active() const { return m_active; }
 
         std::string label() { return m_label; }
 
-        void label(std::string newlabel) { m_label = newlabel + " "; }
+        void label(std::string newlabel) {
+          m_label = newlabel + " ";
+          m_padded_label = pad_label(m_label);
+          changed();
+        }
 
         void draw(SDL_Renderer *renderer) const override {
           auto bounds = m_grid.bounds();
@@ -188,12 +216,12 @@ namespace isolinear::ui {
           );
 
           if (m_label.length() > 0) {
-            m_window.button_font().render_text(
-                renderer,
-                bounds,
-                compass::southeast,
-                std::string{" "} + m_label + " "
+            m_label_text.update(
+                m_window.button_font(),
+                m_window.button_font().text_colour(),
+                m_padded_label
             );
+            m_label_text.draw(renderer, compass::southeast, bounds);
           }
         }
 
@@ -261,19 +289,132 @@ namespace isolinear::ui {
           right_cap.bullnose(renderer, isolinear::compass::east, calculate_colour());
           filler.fill(renderer, calculate_colour());
 
-          m_window.button_font().render_text(
-              renderer,
-              filler,
-              compass::southeast,
-              std::string{" "} + m_label + " "
+          m_label_text.update(
+              m_window.button_font(),
+              m_window.button_font().text_colour(),
+              m_padded_label
           );
+          m_label_text.draw(renderer, compass::southeast, filler);
+        }
+    };
+
+    // Insertion-ordered button storage.
+    //
+    // Buttons are constructed in place inside blocks that never move, so
+    // references and handles stay valid as the set grows. Reserving up
+    // front puts every button in a single block.
+    class button_set {
+    public:
+        using handle = uint32_t;
+        static constexpr handle npos = ~handle{0};
+
+    protected:
+        struct block {
+            button *storage;
+            std::size_t capacity;
+            std::size_t used;
+        };
+
+        std::allocator<button> m_allocator;
+        std::vector<block> m_blocks;
+        std::vector<button *> m_buttons;
+        std::unordered_map<std::string, handle> m_index;
+
+    public:
+        button_set() = default;
+        button_set(const button_set &) = delete;
+        button_set &operator=(const button_set &) = delete;
+
+        ~button_set() {
+          for (auto it = m_buttons.rbegin(); it != m_buttons.rend(); ++it) {
+            std::destroy_at(*it);
+          }
+          for (auto &b: m_blocks) {
+            m_allocator.deallocate(b.storage, b.capacity);
+          }
+        }
+
+        // Buttons only go into the last block, so free slots in earlier
+        // blocks do not count towards n.
+        void reserve(std::size_t n) {
+          std::size_t room = m_blocks.empty() ? 0 : m_blocks.back().capacity - m_blocks.back().used;
+          if (n > size() + room) {
+            add_block(n - size());
+          }
+          m_buttons.reserve(n);
+          m_index.reserve(n);
+        }
+
+        std::size_t capacity() const {
+          std::size_t total = 0;
+          for (auto const &b: m_blocks) {
+            total += b.capacity;
+          }
+          return total;
+        }
+
+        std::size_t size() const {
+          return m_buttons.size();
+        }
+
+        bool empty() const {
+          return m_buttons.empty();
+        }
+
+        template<typename... Args>
+        button &emplace(const std::string &label, Args &&... args) {
+          if (auto h = find(label); h != npos) {
+            return at(h);
+          }
+
+          if (m_blocks.empty() || m_blocks.back().used == m_blocks.back().capacity) {
+            add_block(std::max<std::size_t>(4, size()));
+          }
+
+          block &b = m_blocks.back();
+          button *slot = b.storage + b.used;
+          std::construct_at(slot, std::forward<Args>(args)...);
+          ++b.used;
+
+          m_index.emplace(label, static_cast<handle>(m_buttons.size()));
+          m_buttons.push_back(slot);
+          return *slot;
+        }
+
+        handle find(const std::string &label) const {
+          auto it = m_index.find(label);
+          return it == m_index.end() ? npos : it->second;
+        }
+
+        bool contains(const std::string &label) const {
+          return find(label) != npos;
+        }
+
+        button &at(handle h) const {
+          return *m_buttons.at(h);
+        }
+
+        button &at(const std::string &label) const {
+          handle h = find(label);
+          if (h == npos) {
+            throw std::out_of_range("No button labelled " + label);
+          }
+          return *m_buttons[h];
+        }
+
+        auto begin() const { return m_buttons.begin(); }
+        auto end() const { return m_buttons.end(); }
+
+    protected:
+        void add_block(std::size_t n) {
+          m_blocks.push_back({m_allocator.allocate(n), n, 0});
         }
     };
 
     class button_bar : public control {
     protected:
         display::window &m_window;
-        std::map<std::string, isolinear::ui::button> m_buttons;
+        button_set m_buttons;
         geometry::vector m_button_size{2, 2};
 
     public:
@@ -284,26 +425,31 @@ namespace isolinear::ui {
 
         virtual layout::grid calculate_bar_grid() const = 0;
 
-        theme::colour_scheme colours() const override {
-          return control::colours();
+        void on_palette_changed() override {
+          control::on_palette_changed();
+          for (auto *button: m_buttons) {
+            button->inherit_palette(m_palette);
+          }
         }
 
-        void colours(theme::colour_scheme cs) override {
-          for (auto &[label, button]: m_buttons) {
-            button.colours(cs);
-          }
-          control::colours(cs);
+        void reserve_buttons(std::size_t n) {
+          m_buttons.reserve(n);
         }
 
         virtual isolinear::ui::button &add_button(std::string label) {
-          m_buttons.try_emplace(
+          if (m_buttons.contains(label)) {
+            return m_buttons.at(label);
+          }
+
+          auto &button = m_buttons.emplace(
               label,
               m_window,
               calculate_button_grid(m_buttons.size() + 1),
               label
           );
-          auto &button = m_buttons.at(label);
-          button.colours(colours());
+          button.parent(this);
+          button.inherit_palette(m_palette);
+          changed();
           return button;
         }
 
@@ -312,8 +458,8 @@ namespace isolinear::ui {
         }
 
         virtual void deactivate_all() {
-          for (auto &[label, button]: m_buttons) {
-            button.deactivate();
+          for (auto *button: m_buttons) {
+            button->deactivate();
           }
         }
 
@@ -323,15 +469,15 @@ namespace isolinear::ui {
 
         void on_pointer_event(event::pointer event) override {
           control::on_pointer_event(event);
-          for (auto &[label, button]: m_buttons) {
-            button.on_pointer_event(event);
+          for (auto *button: m_buttons) {
+            button->on_pointer_event(event);
           }
         };
 
         void on_keyboard_event(event::keyboard event) override {
           control::on_keyboard_event(event);
-          for (auto &[label, button]: m_buttons) {
-            button.on_keyboard_event(event);
+          for (auto *button: m_buttons) {
+            button->on_keyboard_event(event);
           }
         }
 
@@ -340,8 +486,8 @@ namespace isolinear::ui {
         }
 
         void draw(SDL_Renderer *renderer) const override {
-          for (auto const &[label, button]: m_buttons) {
-            button.draw(renderer);
+          for (auto const *button: m_buttons) {
+            button->draw(renderer);
           }
 
           region bar = calculate_bar_grid().bounds();
@@ -417,6 +563,8 @@ namespace isolinear::ui {
         display::window &m_window;
         compass m_alignment = compass::centre;
         std::string m_text{""};
+        std::string m_padded{""};
+        mutable text::prepared_text m_header_text;
 
     public:
         header_basic(layout::grid g, display::window &w, std::string t)
@@ -429,18 +577,12 @@ namespace isolinear::ui {
             : header_basic(w, std::move(g), a, t) {}
 
         header_basic(display::window &w, layout::grid g, compass a, std::string t)
-            : control(std::move(g)), m_window{w}, m_alignment{a}, m_text{std::move(t)} {}
+            : control(std::move(g)), m_window{w}, m_alignment{a}, m_text{std::move(t)}, m_padded{pad_label(m_text)} {}
 
         void label(std::string newlabel) {
           m_text = newlabel;
-        }
-
-        virtual theme::colour_scheme colours() const {
-          return control::colours();
-        }
-
-        void colours(theme::colour_scheme cs) override {
-          control::colours(cs);
+          m_padded = pad_label(m_text);
+          changed();
         }
 
         region bounds() const override {
@@ -456,10 +598,8 @@ namespace isolinear::ui {
             return;
           }
 
-          std::string padded = std::string(" ") + m_text + " ";
-
-          text::rendered_text headertext = m_window.header_font().render_text(colours().active, padded);
-          headertext.draw(renderer, m_alignment, m_grid.bounds());
+          m_header_text.update(m_window.header_font(), colours().active, m_padded);
+          m_header_text.draw(renderer, m_alignment, m_grid.bounds());
         }
     };
 
@@ -467,10 +607,10 @@ namespace isolinear::ui {
     protected:
         display::window &m_window;
         std::string m_text;
-        std::map<std::string, isolinear::ui::button> m_buttons;
+        button_set m_buttons;
         int m_button_width{2};
-        theme::colour m_left_cap_colour{};
-        theme::colour m_right_cap_colour{};
+        mutable std::string m_padded; // Reused so padding label() does not allocate
+        mutable text::prepared_text m_header_text;
 
     public:
         header_east_bar(display::window &w, layout::grid g, std::string t)
@@ -487,43 +627,47 @@ namespace isolinear::ui {
 
         void label(std::string newlabel) {
           m_text = std::move(newlabel);
+          changed();
         }
 
-        virtual std::string label() const {
+        virtual const std::string &label() const {
           return m_text;
         }
 
-        theme::colour_scheme colours() const override {
-          return control::colours();
-        }
-
-        void colours(theme::colour_scheme cs) override {
-          m_left_cap_colour = cs.light;
-          m_right_cap_colour = cs.light;
-
-          for (auto &[label, button]: m_buttons) {
-            button.colours(cs);
+        void on_palette_changed() override {
+          control::on_palette_changed();
+          for (auto *button: m_buttons) {
+            button->inherit_palette(m_palette);
           }
-
-          control::colours(cs);
         }
 
         virtual theme::colour left_cap_colour() const {
-          return m_left_cap_colour;
+          return colours().light;
         }
 
         virtual theme::colour right_cap_colour() const {
-          return m_right_cap_colour;
+          return colours().light;
+        }
+
+        void reserve_buttons(std::size_t n) {
+          m_buttons.reserve(n);
         }
 
         isolinear::ui::button &add_button(std::string label) {
-          m_buttons.try_emplace(
+          if (m_buttons.contains(label)) {
+            return m_buttons.at(label);
+          }
+
+          auto &button = m_buttons.emplace(
               label,
               m_window,
               calculate_button_grid(m_buttons.size() + 1),
               label
           );
-          return m_buttons.at(label);
+          button.parent(this);
+          button.inherit_palette(m_palette);
+          changed();
+          return button;
         }
 
         layout::grid calculate_button_grid(int i) const {
@@ -536,8 +680,8 @@ namespace isolinear::ui {
 
         void on_pointer_event(event::pointer event) override {
           control::on_pointer_event(event);
-          for (auto &[label, button]: m_buttons) {
-            button.on_pointer_event(event);
+          for (auto *button: m_buttons) {
+            button->on_pointer_event(event);
           }
         };
 
@@ -565,17 +709,17 @@ namespace isolinear::ui {
           centre_bar.fill(renderer, colours().background);
 
           if (m_buttons.size() > 0) {
-            for (auto const &[label, button]: m_buttons) {
-              button.draw(renderer);
+            for (auto const *button: m_buttons) {
+              button->draw(renderer);
               filler_start += m_button_width;
             }
           }
 
-          auto header_text = label();
+          auto const &header_text = label();
           if (header_text.length() > 0) {
-            std::string padded = std::string(" ") + header_text + " ";
-            text::rendered_text headertext = m_window.header_font().render_text(colours().active, padded);
-            region headerregion = centre_bar.align(compass::east, headertext.size());
+            m_padded.assign(" ").append(header_text).append(" ");
+            auto const &headerfont = m_window.header_font();
+            region headerregion = centre_bar.align(compass::east, headerfont.measure(m_padded));
 
             int near = m_grid.position_column_index(headerregion.near());
             int far = m_grid.position_column_index(headerregion.far());
@@ -592,7 +736,8 @@ namespace isolinear::ui {
             };
             fillerregion.fill(renderer, right_cap_colour());
 
-            headertext.draw(renderer, compass::east, centre_bar);
+            m_header_text.update(headerfont, colours().active, m_padded);
+            m_header_text.draw(renderer, compass::east, centre_bar);
           }
 
           m_grid.calculate_grid_region(
@@ -607,26 +752,27 @@ namespace isolinear::ui {
         display::window &m_window;
         std::string m_left{""};
         std::string m_right{""};
+        std::string m_padded_left{""};
+        std::string m_padded_right{""};
+        mutable text::prepared_text m_left_text;
+        mutable text::prepared_text m_right_text;
 
     public:
         header_pair_bar(layout::grid g, display::window &w,
                         std::string l, std::string r)
-            : control{g}, m_window{w}, m_left{l}, m_right{r} {};
+            : control{g}, m_window{w}, m_left{l}, m_right{r}
+            , m_padded_left{pad_label(l)}, m_padded_right{pad_label(r)} {};
 
         void left(std::string newlabel) {
           m_left = newlabel;
+          m_padded_left = pad_label(m_left);
+          changed();
         }
 
         void right(std::string newlabel) {
           m_right = newlabel;
-        }
-
-        virtual theme::colour_scheme colours() const {
-          return control::colours();
-        }
-
-        virtual void colours(theme::colour_scheme cs) {
-          control::colours(cs);
+          m_padded_right = pad_label(m_right);
+          changed();
         }
 
         virtual region bounds() const override {
@@ -649,22 +795,13 @@ namespace isolinear::ui {
               m_grid.max_columns(), m_grid.max_rows()
           );
 
-          std::string paddedleft = " " + m_left + " ";
-          std::string paddedright = " " + m_right + " ";
-
           auto const &headerfont = m_window.header_font();
-          text::rendered_text lefttext = headerfont.render_text(
-              colours().active, paddedleft
-          );
-          text::rendered_text righttext = headerfont.render_text(
-              colours().active, paddedright
-          );
 
           region lefttextregion = centre_bar.align(
-              compass::west, lefttext.size()
+              compass::west, headerfont.measure(m_padded_left)
           );
           region righttextregion = centre_bar.align(
-              compass::east, righttext.size()
+              compass::east, headerfont.measure(m_padded_right)
           );
 
           position leftlimit = lefttextregion.southeast();
@@ -716,8 +853,10 @@ namespace isolinear::ui {
           left_cap.bullnose(renderer, compass::west, colours().light);
           right_cap.bullnose(renderer, compass::east, colours().light);
 
-          lefttext.draw(renderer, compass::west, centre_bar);
-          righttext.draw(renderer, compass::east, centre_bar);
+          m_left_text.update(headerfont, colours().active, m_padded_left);
+          m_right_text.update(headerfont, colours().active, m_padded_right);
+          m_left_text.draw(renderer, compass::west, centre_bar);
+          m_right_text.draw(renderer, compass::east, centre_bar);
         }
     };
 
@@ -725,19 +864,21 @@ namespace isolinear::ui {
     protected:
         display::window &m_window;
         std::string m_text;
+        std::string m_padded;
+        mutable text::prepared_text m_label_text;
 
     public:
         label(display::window &w, layout::grid g, std::string l)
-            : m_window(w), control(g), m_text(l) {}
+            : m_window(w), control(g), m_text(l), m_padded(pad_label(l)) {}
 
     public:
         void draw(SDL_Renderer *renderer) const {
-          m_window.label_font().render_text(
-              renderer,
-              m_grid.bounds(),
-              compass::west,
-              std::string{" "} + m_text + " "
+          m_label_text.update(
+              m_window.label_font(),
+              m_window.label_font().text_colour(),
+              m_padded
           );
+          m_label_text.draw(renderer, compass::west, m_grid.bounds());
         }
 
     };
@@ -908,22 +1049,34 @@ namespace isolinear::ui {
     class horizontal_progress_bar : public control {
     protected:
         unsigned m_max = 100;
-        unsigned m_value = 50;
+        std::atomic<unsigned> m_value = 50;
         unsigned m_gutter = 6;
 
         bool m_draw_stripes = true;
         bool m_draw_tail = true;
+        bool m_cache_track = true;
 
-        theme::colour m_bar_colour;
         region m_bar_region;
         geometry::vector m_segment_size;
         unsigned m_remainder_px = 0;
         unsigned m_n_segments = 0;
 
+        std::atomic<bool> m_change_pending{false};
+
+        // Frame, background and stripes, rendered once per palette version
+        mutable SDL_Texture *m_track_texture{nullptr};
+        mutable SDL_Renderer *m_track_renderer{nullptr};
+        mutable const theme::palette *m_track_palette{nullptr};
+        mutable unsigned m_track_version{0};
+        mutable bool m_track_stripes{false};
+
 
     public:
         miso::signal<> signal_valuechanged;
 
+        horizontal_progress_bar( const horizontal_progress_bar& ) = delete;
+        horizontal_progress_bar& operator=( const horizontal_progress_bar& ) = delete;
+
         horizontal_progress_bar(layout::grid _g, unsigned _v)
             : control{_g}, m_bar_region(
             position(
@@ -936,12 +1089,18 @@ namespace isolinear::ui {
             )
         ), m_segment_size{(int) m_gutter, m_bar_region.H()},
               m_n_segments{(unsigned) (m_bar_region.W() / m_segment_size.x)},
-              m_remainder_px{static_cast<unsigned int>(m_bar_region.W() % m_segment_size.x)}, m_value{_v},
-              m_bar_colour{theme::nightgazer_colours.active} {};
+              m_remainder_px{static_cast<unsigned int>(m_bar_region.W() % m_segment_size.x)}, m_value{_v} {};
 
         horizontal_progress_bar(layout::grid _g)
             : horizontal_progress_bar(_g, 0) {};
 
+        ~horizontal_progress_bar() {
+          frame::deferred().cancel(this);
+          if (m_track_texture) {
+            SDL_DestroyTexture(m_track_texture);
+          }
+        }
+
         unsigned max() const {
           return m_max;
         }
@@ -952,39 +1111,48 @@ namespace isolinear::ui {
           }
 
           m_max = m;
+          changed();
         }
 
         unsigned value() {
           return m_value;
         }
 
+        // Safe to call from any thread and at any rate; signal_valuechanged
+        // is emitted at most once per frame, on the UI thread.
         void value(unsigned v) {
-          if (v == m_value) {
-            return;
+          if (v > m_max) {
+            v = m_max;
           }
 
-          if (v > m_max) {
-            m_value = m_max;
-          } else {
-            m_value = v;
+          if (m_value.exchange(v) == v) {
+            return;
           }
 
-          emit signal_valuechanged();
+          if (!m_change_pending.exchange(true)) {
+            frame::deferred().push(this, [this]() {
+              m_change_pending = false;
+              changed();
+              emit signal_valuechanged();
+            });
+          }
         }
 
         void increment(unsigned v) {
-          if (m_value + v > m_max) {
+          unsigned current = m_value;
+          if (current + v > m_max) {
             value(m_max);
           } else {
-            value(m_value + v);
+            value(current + v);
           }
         }
 
         void decrement(unsigned v) {
-          if (v > m_value) {
+          unsigned current = m_value;
+          if (v > current) {
             value(0);
           } else {
-            value(m_value - v);
+            value(current - v);
           }
         }
 
@@ -1002,6 +1170,7 @@ namespace isolinear::ui {
 
         void draw_tail(bool v) {
           m_draw_tail = v;
+          changed();
         }
 
         bool draw_stripes() const {
@@ -1010,6 +1179,16 @@ namespace isolinear::ui {
 
         void draw_stripes(bool v) {
           m_draw_stripes = v;
+          changed();
+        }
+
+        bool cache_track() const {
+          return m_cache_track;
+        }
+
+        void cache_track(bool v) {
+          m_cache_track = v;
+          changed();
         }
 
         region bounds() const override {
@@ -1017,50 +1196,593 @@ namespace isolinear::ui {
         }
 
         void draw(SDL_Renderer *renderer) const override {
+          region b = m_grid.bounds();
+
+          if (m_cache_track && prepare_track_texture(renderer)) {
+            SDL_Rect dst{b.near_x(), b.near_y(), b.W() + 1, b.H() + 1};
+            SDL_RenderCopy(renderer, m_track_texture, NULL, &dst);
+          }
+          else {
+            draw_track(renderer, b.near());
+          }
+
+          // Head and tail are the same colour, so they collapse into one rect
+          int head_x = m_bar_region.near_x() + (m_segment_size.x * filled_segments());
+          int fill_x = m_draw_tail ? m_bar_region.near_x() : head_x;
+
+          region{
+              position{fill_x, m_bar_region.near_y()},
+              position{head_x + m_segment_size.x, m_bar_region.near_y() + m_segment_size.y}
+          }.fill(renderer, colours().active);
+        }
+
+    protected:
+        // Draws the static part of the bar with the grid's near corner at origin.
+        void draw_track(SDL_Renderer *renderer, position origin) const {
+          region b = m_grid.bounds();
+          int dx = origin.x - b.near_x();
+          int dy = origin.y - b.near_y();
+
           boxColor(renderer,
-                   m_grid.bounds().near_x(), m_grid.bounds().near_y(),
-                   m_grid.bounds().far_x(), m_grid.bounds().far_y(),
+                   b.near_x() + dx, b.near_y() + dy,
+                   b.far_x() + dx, b.far_y() + dy,
                    colours().frame
           );
           boxColor(renderer,
-                   m_grid.bounds().near_x() + m_gutter, m_grid.bounds().near_y() + m_gutter,
-                   m_grid.bounds().far_x() - m_gutter, m_grid.bounds().far_y() - m_gutter,
+                   b.near_x() + m_gutter + dx, b.near_y() + m_gutter + dy,
+                   b.far_x() - m_gutter + dx, b.far_y() - m_gutter + dy,
                    colours().background
           );
 
           if (m_draw_stripes) {
-            for (int i = 0; i < m_n_segments; i++) {
-              region region{
-                  position{m_bar_region.near().x + (m_segment_size.x * i), m_bar_region.near().y},
+            for (int i = 1; i < m_n_segments; i += 2) {
+              region{
+                  position{m_bar_region.near_x() + (m_segment_size.x * i) + dx, m_bar_region.near_y() + dy},
                   m_segment_size
-              };
+              }.fill(renderer, colours().light_alternate);
+            }
+          }
+        }
+
+        bool prepare_track_texture(SDL_Renderer *renderer) const {
+          bool fresh = m_track_texture
+                    && m_track_renderer == renderer
+                    && m_track_palette == m_palette.get()
+                    && m_track_version == colours_version()
+                    && m_track_stripes == m_draw_stripes;
+          if (fresh) {
+            return true;
+          }
+
+          region b = m_grid.bounds();
+
+          if (!m_track_texture || m_track_renderer != renderer) {
+            if (m_track_texture) {
+              SDL_DestroyTexture(m_track_texture);
+            }
+            m_track_texture = SDL_CreateTexture(
+                renderer, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_TARGET,
+                b.W() + 1, b.H() + 1
+            );
+            if (!m_track_texture) {
+              return false; // Renderer without target textures; draw directly
+            }
+            SDL_SetTextureBlendMode(m_track_texture, SDL_BLENDMODE_BLEND);
+            m_track_renderer = renderer;
+          }
+
+          SDL_Texture *previous = SDL_GetRenderTarget(renderer);
+          SDL_SetRenderTarget(renderer, m_track_texture);
+          SDL_SetRenderDrawColor(renderer, 0, 0, 0, 0);
+          SDL_RenderClear(renderer);
+          draw_track(renderer, position{0, 0});
+          SDL_SetRenderTarget(renderer, previous);
+
+          m_track_palette = m_palette.get();
+          m_track_version = colours_version();
+          m_track_stripes = m_draw_stripes;
+          return true;
+        }
+    };
+
+    // Streaming time-series chart.
+    //
+    // Each series is fed through its own lock-free ring, so a producer
+    // thread can push at any rate. Every `samples_per_column` samples are
+    // decimated to one min/max pixel column. Columns go into a circular
+    // texture, so a frame only draws the columns that arrived since the
+    // last one and blits the texture as two rects to scroll it.
+    class chart : public control {
+    public:
+        using colour_ref = theme::colour theme::colour_scheme::*;
+        using series_handle = std::size_t;
+
+    protected:
+        struct column {
+            float low;
+            float high;
+            bool empty;
+        };
+
+        struct series {
+            colour_ref colour;
+            spsc_ring<float, 1 << 14> samples;
+            float acc_low{0};
+            float acc_high{0};
+            unsigned acc_count{0};
+            std::vector<column> pending;
+            std::vector<column> history; // Circular, indexed like the texture's columns
+        };
+
+        std::vector<std::unique_ptr<series>> m_series;
+        unsigned m_samples_per_column{1};
+        float m_low;
+        float m_high;
+
+        mutable std::size_t m_next_column{0};
+        mutable SDL_Texture *m_texture{nullptr};
+        mutable SDL_Renderer *m_texture_renderer{nullptr};
+        mutable const theme::palette *m_texture_palette{nullptr};
+        mutable unsigned m_texture_version{0};
+        mutable bool m_redraw_all{true};
+
+    public:
+        chart( const chart& ) = delete;
+        chart& operator=( const chart& ) = delete;
+
+        chart(layout::grid g, float low, float high, unsigned samples_per_column = 1)
+            : control(std::move(g))
+            , m_samples_per_column{std::max(1u, samples_per_column)}
+            , m_low{low}
+            , m_high{high} {}
+
+        ~chart() {
+          if (m_texture) {
+            SDL_DestroyTexture(m_texture);
+          }
+        }
+
+        series_handle add_series(colour_ref colour) {
+          auto s = std::make_unique<series>();
+          s->colour = colour;
+          s->pending.reserve(width());
+          s->history.assign(width(), column{0, 0, true});
+          m_series.push_back(std::move(s));
+          m_redraw_all = true;
+          changed();
+          return m_series.size() - 1;
+        }
+
+        // Callable from one producer thread per series.
+        bool push(series_handle h, float value) {
+          return m_series[h]->samples.push(value);
+        }
+
+        void range(float low, float high) {
+          m_low = low;
+          m_high = high;
+          m_redraw_all = true;
+          changed();
+        }
+
+        void samples_per_column(unsigned n) {
+          m_samples_per_column = std::max(1u, n);
+        }
+
+        int width() const {
+          return m_grid.bounds().W();
+        }
+
+        int height() const {
+          return m_grid.bounds().H();
+        }
+
+        region bounds() const override {
+          return m_grid.bounds();
+        }
 
-              if (i % 2 == 0) {
-                region.fill(renderer, colours().background);
-              } else {
-                region.fill(renderer, colours().light_alternate);
+        // New samples waiting in any ring.
+        bool needs_redraw() const override {
+          return control::needs_redraw()
+              || std::any_of(m_series.begin(), m_series.end(), [](auto const &s) { return s->samples.size() > 0; });
+        }
+
+        void draw(SDL_Renderer *renderer) const override {
+          region b = m_grid.bounds();
+          b.fill(renderer, colours().background);
+
+          if (width() <= 0 || !prepare_texture(renderer)) {
+            return;
+          }
+
+          std::size_t new_columns = decimate();
+
+          SDL_Texture *previous = SDL_GetRenderTarget(renderer);
+          SDL_SetRenderTarget(renderer, m_texture);
+
+          if (m_redraw_all) {
+            for (int x = 0; x < width(); x++) {
+              draw_column(renderer, x);
+            }
+            m_redraw_all = false;
+          }
+          else {
+            auto columns = static_cast<std::size_t>(width());
+            std::size_t first = new_columns > columns ? new_columns - columns : 0;
+            for (std::size_t c = first; c < new_columns; c++) {
+              draw_column(renderer, (m_next_column - new_columns + c) % columns);
+            }
+          }
+
+          SDL_SetRenderTarget(renderer, previous);
+
+          // Oldest column sits at m_next_column; blit it to the left edge
+          int split = m_next_column % width();
+          SDL_Rect older_src{split, 0, width() - split, height()};
+          SDL_Rect older_dst{b.near_x(), b.near_y(), width() - split, height()};
+          SDL_Rect newer_src{0, 0, split, height()};
+          SDL_Rect newer_dst{b.near_x() + width() - split, b.near_y(), split, height()};
+
+          SDL_RenderCopy(renderer, m_texture, &older_src, &older_dst);
+          if (split > 0) {
+            SDL_RenderCopy(renderer, m_texture, &newer_src, &newer_dst);
+          }
+        }
+
+    protected:
+        // Drains every ring into min/max columns; returns how many columns to advance.
+        std::size_t decimate() const {
+          std::size_t advance = 0;
+
+          for (auto const &sp: m_series) {
+            series &s = *sp;
+            s.pending.clear();
+            s.samples.drain([&](float v) {
+              if (s.acc_count == 0) {
+                s.acc_low = s.acc_high = v;
+              }
+              else {
+                s.acc_low = std::min(s.acc_low, v);
+                s.acc_high = std::max(s.acc_high, v);
+              }
+
+              // >= as samples_per_column() may drop below a partial column
+              if (++s.acc_count >= m_samples_per_column) {
+                s.pending.push_back({s.acc_low, s.acc_high, false});
+                s.acc_count = 0;
               }
+            });
+            advance = std::max(advance, s.pending.size());
+          }
+
+          for (std::size_t c = 0; c < advance; c++) {
+            std::size_t x = (m_next_column + c) % width();
+            for (auto const &sp: m_series) {
+              sp->history[x] = (c < sp->pending.size())
+                             ? sp->pending[c]
+                             : column{0, 0, true};
             }
           }
 
-          theme::colour m_bar_colour = colours().active;
+          m_next_column += advance;
+          return advance;
+        }
 
-          region filled_region{
-              position{static_cast<int>(m_bar_region.near().x + (m_segment_size.x * filled_segments())),
-                       m_bar_region.near().y},
-              m_segment_size
-          };
-          filled_region.fill(renderer, m_bar_colour);
+        int value_to_y(float v) const {
+          float t = (v - m_low) / (m_high - m_low);
+          t = std::clamp(t, 0.0f, 1.0f);
+          return static_cast<int>((height() - 1) * (1.0f - t));
+        }
 
-          if (m_draw_tail) {
-            for (int i = 0; i < filled_segments(); i++) {
-              region region{
-                  position{m_bar_region.near().x + (m_segment_size.x * i), m_bar_region.near().y},
-                  m_segment_size
-              };
-              region.fill(renderer, m_bar_colour);
+        void draw_column(SDL_Renderer *renderer, int x) const {
+          SDL_Rect clear{x, 0, 1, height()};
+          SDL_SetRenderDrawBlendMode(renderer, SDL_BLENDMODE_NONE);
+          SDL_SetRenderDrawColor(renderer, 0, 0, 0, 0);
+          SDL_RenderFillRect(renderer, &clear);
+          SDL_SetRenderDrawBlendMode(renderer, SDL_BLENDMODE_BLEND);
+
+          for (auto const &sp: m_series) {
+            column const &c = sp->history[x];
+            if (c.empty) {
+              continue;
+            }
+            boxColor(renderer,
+                     x, value_to_y(c.high),
+                     x, value_to_y(c.low),
+                     colours().*(sp->colour)
+            );
+          }
+        }
+
+        bool prepare_texture(SDL_Renderer *renderer) const {
+          if (!m_texture || m_texture_renderer != renderer) {
+            if (m_texture) {
+              SDL_DestroyTexture(m_texture);
+            }
+            m_texture = SDL_CreateTexture(
+                renderer, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_TARGET,
+                width(), height()
+            );
+            if (!m_texture) {
+              return false;
+            }
+            SDL_SetTextureBlendMode(m_texture, SDL_BLENDMODE_BLEND);
+            m_texture_renderer = renderer;
+            m_redraw_all = true;
+          }
+
+          if (m_texture_palette != m_palette.get() || m_texture_version != colours_version()) {
+            m_texture_palette = m_palette.get();
+            m_texture_version = colours_version();
+            m_redraw_all = true;
+          }
+
+          return true;
+        }
+    };
+
+    // Scrolling log/list that only renders the rows in view.
+    //
+    // Rows are laid out one per grid row. A fixed pool of row slots, one
+    // more than fits on screen, is keyed by entry sequence number modulo
+    // the pool size, so scrolling and appending only rasterise rows that
+    // come into view. Drag or swipe to scroll; releasing a drag keeps the
+    // list moving with friction. While scrolled to the end, new entries
+    // keep the tail in view.
+    class log_list : public control {
+    protected:
+        struct row {
+            std::size_t seq{~std::size_t{0}};
+            unsigned version{0};
+            SDL_Texture *texture{nullptr};
+            geometry::vector capacity{0};
+            geometry::vector size{0};
+        };
+
+        display::window &m_window;
+        std::deque<std::string> m_entries;
+        std::size_t m_first_seq{0}; // Sequence number of m_entries.front()
+        std::size_t m_max_entries;
+
+        mutable std::vector<row> m_rows;
+
+        // Scroll state in pixels from the top of the content
+        mutable double m_scroll{0};
+        mutable double m_velocity{0}; // px per ms
+        mutable Uint32 m_last_frame{0};
+        mutable bool m_following{true};
+
+        bool m_dragging{false};
+        int m_drag_y{0};
+        Uint32 m_drag_time{0};
+
+        static constexpr double friction_ms = 325.0;
+
+    public:
+        log_list( const log_list& ) = delete;
+        log_list& operator=( const log_list& ) = delete;
+
+        log_list(display::window &w, layout::grid g, std::size_t max_entries = 0)
+            : control(std::move(g))
+            , m_window{w}
+            , m_max_entries{max_entries}
+            , m_rows(m_grid.max_rows() + 1) {}
+
+        ~log_list() {
+          for (auto &r: m_rows) {
+            if (r.texture) {
+              SDL_DestroyTexture(r.texture);
             }
           }
         }
+
+        // O(1); only the new row is rasterised, and only if it is in view.
+        void append(std::string entry) {
+          m_entries.push_back(std::move(entry));
+
+          if (m_max_entries > 0 && m_entries.size() > m_max_entries) {
+            m_entries.pop_front();
+            ++m_first_seq;
+            m_scroll = std::max(0.0, m_scroll - pitch());
+          }
+
+          if (m_following) {
+            m_scroll = max_scroll();
+          }
+          changed();
+        }
+
+        void clear() {
+          m_first_seq += m_entries.size();
+          m_entries.clear();
+          m_scroll = 0;
+          m_velocity = 0;
+          m_following = true;
+          changed();
+        }
+
+        std::size_t size() const {
+          return m_entries.size();
+        }
+
+        const std::string &at(std::size_t i) const {
+          return m_entries.at(i);
+        }
+
+        bool following() const {
+          return m_following;
+        }
+
+        void scroll_to_end() {
+          m_velocity = 0;
+          m_scroll = max_scroll();
+          m_following = true;
+          changed();
+        }
+
+        void scroll_by(double px) {
+          m_scroll = std::clamp(m_scroll + px, 0.0, max_scroll());
+          m_following = m_scroll >= max_scroll();
+          changed();
+        }
+
+        region bounds() const override {
+          return m_grid.bounds();
+        }
+
+        // Still coasting after a flick.
+        bool needs_redraw() const override {
+          return control::needs_redraw() || (!m_dragging && m_velocity != 0);
+        }
+
+        void on_pointer_event(event::pointer event) override {
+          control::on_pointer_event(event);
+
+          if (event.is_mouse_up() || event.is_finger_up()) {
+            m_dragging = false;
+            return;
+          }
+
+          if (!m_dragging) {
+            return;
+          }
+
+          Uint32 dt = std::max<Uint32>(1, event.timestamp() - m_drag_time);
+          int dy = event.position().y - m_drag_y;
+
+          scroll_by(-dy);
+          m_velocity = -static_cast<double>(dy) / dt;
+          m_drag_y = event.position().y;
+          m_drag_time = event.timestamp();
+        }
+
+        void on_mouse_down(event::pointer event) override {
+          start_drag(event);
+        }
+
+        void on_finger_down(event::pointer event) override {
+          start_drag(event);
+        }
+
+        void draw(SDL_Renderer *renderer) const override {
+          advance_kinetic_scroll();
+
+          region b = m_grid.bounds();
+          if (m_entries.empty()) {
+            return;
+          }
+
+          SDL_Rect clip{b.X(), b.Y(), b.W() + 1, b.H() + 1};
+          SDL_RenderSetClipRect(renderer, &clip);
+
+          int p = pitch();
+          std::size_t first = static_cast<std::size_t>(m_scroll) / p;
+          int offset = static_cast<int>(m_scroll) % p;
+
+          for (std::size_t k = 0; k < m_rows.size(); k++) {
+            std::size_t i = first + k;
+            if (i >= m_entries.size()) {
+              break;
+            }
+
+            row &r = row_for(renderer, i);
+            if (!r.texture || r.size.x == 0) {
+              continue;
+            }
+
+            int row_y = b.Y() + static_cast<int>(k) * p - offset;
+            SDL_Rect src{0, 0, r.size.x, r.size.y};
+            SDL_Rect dst{
+                b.X(),
+                row_y + ((p - m_grid.gutter().y) - r.size.y) / 2,
+                r.size.x,
+                r.size.y
+            };
+            SDL_RenderCopy(renderer, r.texture, &src, &dst);
+          }
+
+          SDL_RenderSetClipRect(renderer, NULL);
+        }
+
+    protected:
+        int pitch() const {
+          return std::max(1, m_grid.cell_size().y);
+        }
+
+        double max_scroll() const {
+          double content = static_cast<double>(m_entries.size()) * pitch();
+          return std::max(0.0, content - m_grid.bounds().H());
+        }
+
+        void start_drag(event::pointer event) {
+          m_dragging = true;
+          m_velocity = 0;
+          m_drag_y = event.position().y;
+          m_drag_time = event.timestamp();
+        }
+
+        void advance_kinetic_scroll() const {
+          Uint32 now = SDL_GetTicks();
+          Uint32 dt = (m_last_frame == 0) ? 0 : now - m_last_frame;
+          m_last_frame = now;
+
+          if (m_dragging || m_velocity == 0 || dt == 0) {
+            return;
+          }
+
+          double target = m_scroll + m_velocity * dt;
+          m_scroll = std::clamp(target, 0.0, max_scroll());
+          m_velocity = (m_scroll == target)
+                     ? m_velocity * std::exp(-dt / friction_ms)
+                     : 0;
+
+          if (std::abs(m_velocity) < 0.01) {
+            m_velocity = 0;
+          }
+
+          m_following = m_scroll >= max_scroll();
+        }
+
+        // Recycles the slot for entry i, rasterising only if it held another
+        // entry. The slot's texture is reused whenever the new text fits.
+        row &row_for(SDL_Renderer *renderer, std::size_t i) const {
+          std::size_t seq = m_first_seq + i;
+          row &r = m_rows[seq % m_rows.size()];
+
+          if (r.seq == seq && r.version == colours_version()) {
+            return r;
+          }
+
+          r.seq = seq;
+          r.version = colours_version();
+          r.size = geometry::vector{0, 0};
+
+          SDL_Surface *surface = m_window.label_font().render_surface(colours().light, m_entries[i]);
+          if (!surface) {
+            return r;
+          }
+
+          int w = std::min<int>(surface->w, m_grid.bounds().W());
+          int h = surface->h;
+
+          if (!r.texture || r.capacity.x < w || r.capacity.y < h) {
+            if (r.texture) {
+              SDL_DestroyTexture(r.texture);
+            }
+            r.capacity = geometry::vector{m_grid.bounds().W(), std::max(h, pitch())};
+            r.texture = SDL_CreateTexture(
+                renderer, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_STREAMING,
+                r.capacity.x, r.capacity.y
+            );
+            SDL_SetTextureBlendMode(r.texture, SDL_BLENDMODE_BLEND);
+          }
+
+          SDL_Rect area{0, 0, w, h};
+          SDL_UpdateTexture(r.texture, &area, surface->pixels, surface->pitch);
+          SDL_FreeSurface(surface);
+
+          r.size = geometry::vector{w, h};
+          return r;
+        }
     };
 }
\ No newline at end of file
@@ -0,0 +1,121 @@
+#include <cmath>
+#include <cstdlib>
+
+#include "init.h"
+#include "layout.h"
+#include "ui.h"
+
+// Headless check that steady-state frames make no heap allocations.
+//
+// Builds a kitchen sink of widgets on SDL's dummy video driver, animates,
+// feeds and scrolls them every frame, and fails if any frame after the
+// warm-up allocates, with operator new or through SDL. Needs
+// ISOLINEAR_COUNT_ALLOCATIONS, which the build defines for this target.
+//
+//   frame_allocations [FRAMES]
+
+#ifndef ISOLINEAR_COUNT_ALLOCATIONS
+#error "frame_allocations must be built with ISOLINEAR_COUNT_ALLOCATIONS"
+#endif
+
+int main(int argc, char* argv[]) {
+  setenv("SDL_VIDEODRIVER", "dummy", 0);
+
+  constexpr uint64_t warmup = 120;
+  uint64_t frames = (argc > 1) ? std::strtoull(argv[1], nullptr, 10) : 600;
+  if (frames <= warmup) {
+    fmt::print(stderr, "usage: {} [FRAMES > {}]\n", argv[0], warmup);
+    return 2;
+  }
+
+  auto work_guard = asio::make_work_guard(isolinear::io_context);
+
+  isolinear::init();
+  auto& window = isolinear::new_window({0, 0}, {1280, 720});
+
+  isolinear::layout::gridfactory gridfactory(
+      { 0, 0, window.size().x, window.size().y }, // Display Region
+      { 60, 30 }, // Cell Size
+      { 6, 6 } // Cell Gutter
+  );
+
+  auto& root_grid = gridfactory.root();
+
+  int hthickness = 2;
+  int vthickness = 3;
+  isolinear::layout::northwest_elbo elbo_layout(root_grid, hthickness + 1, vthickness + 1);
+  isolinear::ui::northwest_sweep nwsweep(window, elbo_layout.sweep(), {vthickness, hthickness}, 50, 20 );
+  isolinear::ui::vertical_button_bar vbbar(window, elbo_layout.vertical_control());
+  isolinear::ui::header_east_bar hbbar(window, elbo_layout.horizontal_control(), "ALLOCATIONS");
+
+  window.add(&nwsweep);
+  window.add(&vbbar);
+  window.add(&hbbar);
+
+  vbbar.add_button("Spoon");
+  vbbar.add_button("Knife");
+  hbbar.add_button("Fork");
+
+  auto content = elbo_layout.content();
+
+  isolinear::ui::header_basic title(content.rows(1, 2), window, "STEADY STATE");
+  window.add(&title);
+
+  isolinear::ui::horizontal_progress_bar progress(content.rows(3, 4), 50);
+  window.add(&progress);
+
+  isolinear::ui::chart graph(content.rows(5, 8), -1, 1);
+  auto series = graph.add_series(&isolinear::theme::colour_scheme::active);
+  window.add(&graph);
+
+  isolinear::ui::log_list log(window, content.rows(9, content.max_rows()), 64);
+  window.add(&log);
+  for (int i = 0; i < 64; i++) {
+    log.append(fmt::format("Entry {}", i));
+  }
+
+  isolinear::animations.value(
+      0, 100, std::chrono::seconds(1),
+      [&](double v){ progress.value(v); },
+      &progress,
+      isolinear::animation::EASE_IN_OUT,
+      isolinear::animation::PING_PONG
+  );
+
+  std::size_t total = 0;
+  uint64_t worst_frame = 0;
+  std::size_t worst = 0;
+
+  isolinear::frame::stats().on_frame([&](uint64_t frame, std::size_t allocations) {
+    if (frame <= warmup) {
+      return;
+    }
+    total += allocations;
+    if (allocations > worst) {
+      worst = allocations;
+      worst_frame = frame;
+    }
+  });
+
+  for (uint64_t i = 0; i < frames; i++) {
+    double t = static_cast<double>(i) / 30;
+    graph.push(series, static_cast<float>(std::sin(t)));
+    log.scroll_by(std::sin(t) * 20);
+
+    if (!isolinear::loop()) {
+      break;
+    }
+  }
+
+  work_guard.reset();
+  isolinear::shutdown();
+
+  if (total > 0) {
+    fmt::print("{} allocations after {} warm-up frames, worst {} in frame {}\n",
+        total, warmup, worst, worst_frame);
+    return 1;
+  }
+
+  fmt::print("No allocations in {} frames after warm-up\n", frames - warmup);
+  return 0;
+}
@@ -1,5 +1,25 @@
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <cstdlib>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <vector>
+
+#include "checkpoint.h"
+#include "gameoflife.h"
 #include "init.h"
 #include "layout.h"
+#include "log.h"
+#include "patterns.h"
+#include "ring.h"
+#include "triple_buffer.h"
 #include "ui.h"
 #include "layout.h"
 #include "fmt/core.h"
@@ -10,230 +30,921 @@ namespace geometry = isolinear::geometry;
 namespace theme = isolinear::theme;
 namespace ui = isolinear::ui;
 
-class gameoflife {
+// Runs a gameoflife on its own thread.
+//
+// Completed generations are published through a triple buffer, so the UI
+// always reads a whole board no matter how far ahead the simulation is,
+// and per-generation statistics are handed over on a lock-free ring.
+// When the UI falls so far behind that the ring fills, statistics are
+// dropped and counted; the published board still carries the latest.
+// Each board carries a version stamp per block of cells, taken from the
+// engine's flip lists, so a renderer can repaint only what changed.
+// Anything that touches the board from the UI thread is queued with
+// apply() and run between generations. Published boards carry everything
+// a checkpoint needs, so one can be taken without stopping the thread.
+class simulation {
 public:
-    using game_state_ptr = std::unique_ptr<bool[]>;
-    struct generation {
-        int alive = 0;
-        int dead = 0;
-        int alive_delta = 0;
-        int dead_delta = 0;
+    using clock = std::chrono::steady_clock;
+
+    struct pace {
+      enum mode {
+        FIXED_RATE, // Generations per second, independent of the frame rate
+        UNLIMITED,  // As fast as the engine can go
+        PER_FRAME   // A fixed number of generations for every rendered frame
+      };
+
+      mode type;
+      double rate;
+      unsigned count;
+
+      static pace fixed(double generations_per_second) { return {FIXED_RATE, generations_per_second, 0}; }
+      static pace unlimited() { return {UNLIMITED, 0, 0}; }
+      static pace per_frame(unsigned n) { return {PER_FRAME, 0, n}; }
+
+      clock::duration period() const {
+        return std::chrono::duration_cast<clock::duration>(std::chrono::duration<double>(1.0 / rate));
+      }
     };
 
-private:
-    geometry::vector m_grid_size;
-    game_state_ptr m_update;
-    game_state_ptr m_display;
-    bool m_grid_wrap{true};
-    generation m_previous_generation;
+    static constexpr int block_cells = 64;
+
+    struct snapshot {
+      gameoflife::vector size;
+      std::vector<uint8_t> cells;
+      std::vector<uint64_t> stamps; // Version at which each block last changed
+      uint64_t version{0};
+      uint64_t number{0};
+      bool wrap{true};
+      rules::rule rule;
+      gameoflife::generation stats;
+    };
+
+protected:
+    gameoflife m_game; // Owned by the simulation thread once started
+    std::vector<uint64_t> m_stamps;
+    uint64_t m_version{1};
+    isolinear::triple_buffer<snapshot> m_boards;
+    isolinear::spsc_ring<gameoflife::generation, 1024> m_generations;
+    std::atomic<uint64_t> m_dropped{0};
+    uint64_t m_number{0};
+
+    std::mutex m_mutex;
+    std::condition_variable m_wake;
+    std::vector<std::function<void(gameoflife&)>> m_commands;
+    pace m_pace{pace::per_frame(1)};
+    bool m_paused{false};
+    unsigned m_credits{0};
+    bool m_stopping{false};
+
+    std::thread m_thread;
 
 public:
-    gameoflife(geometry::vector gs)
-        : m_grid_size(gs)
-        , m_update(std::make_unique<bool[]>(gs.x*gs.y))
-        , m_display(std::make_unique<bool[]>(gs.x*gs.y))
+    simulation(geometry::vector size)
+      : m_game({size.x, size.y})
+      , m_stamps((m_game.n_cells() + block_cells - 1) / block_cells, m_version)
+      , m_boards(capture())
     {
-      initialise(6);
+      m_thread = std::thread([this]() { run(); });
+    }
+
+    simulation(const simulation&) = delete;
+    simulation& operator=(const simulation&) = delete;
+
+    ~simulation() {
+      {
+        std::lock_guard lock(m_mutex);
+        m_stopping = true;
+      }
+      m_wake.notify_one();
+      m_thread.join();
+    }
+
+    geometry::vector size() const {
+      auto [w, h] = m_game.size();
+      return geometry::vector{w, h};
     }
 
     int n_cells() const {
-      return m_grid_size.x * m_grid_size.y;
+      return m_game.n_cells();
+    }
+
+    void apply(std::function<void(gameoflife&)> command) {
+      {
+        std::lock_guard lock(m_mutex);
+        m_commands.push_back(std::move(command));
+      }
+      m_wake.notify_one();
     }
 
-    int n_alive_cells() const {
-      int alive = 0;
-      for (int i=0; i < n_cells(); i++) {
-        if (m_display[i]) {
-          alive++;
+    // Carries on from a checkpoint, if it is for a board of this size.
+    void resume(checkpoint::state saved) {
+      apply([this, saved = std::move(saved)](gameoflife& game) {
+        if (checkpoint::restore(game, saved)) {
+          m_number = saved.number;
         }
+      });
+    }
+
+    void speed(pace p) {
+      {
+        std::lock_guard lock(m_mutex);
+        m_pace = p;
+        m_credits = 0;
       }
-      return alive;
+      m_wake.notify_one();
     }
 
-    void initialise(const int factor) {
-      for (int i = 0; i < n_cells(); i++) {
-        m_display[i] = rand() % factor == 0;
-        m_update[i] = 0;
+    bool pause() {
+      bool paused;
+      {
+        std::lock_guard lock(m_mutex);
+        m_paused = !m_paused;
+        m_credits = 0;
+        paused = m_paused;
       }
+      m_wake.notify_one();
+      return paused;
     }
 
-    void mutate(const int factor) {
-      for (int i = 0; i < n_cells(); i++) {
-        if (!m_display[i]) {
-          m_display[i] = rand() % factor == 0;
+    // Advances one generation while paused.
+    void step() {
+      {
+        std::lock_guard lock(m_mutex);
+        if (!m_paused) {
+          return;
         }
+        m_credits++;
       }
+      m_wake.notify_one();
     }
 
-    bool wrap() {
-      m_grid_wrap = !m_grid_wrap;
-      return m_grid_wrap;
-    }
-
-    int alive_neighbours_of(const geometry::vector cell) const {
-      std::array<std::pair<int,int>, 8> neighbours{{
-          {-1, -1},  // Northwest
-          { 0, -1},  // North
-          {+1, -1},  // Northeast
-
-          {-1,  0},  // West
-          {+1,  0},  // East
-
-          {-1, +1},  // Southwest
-          { 0, +1},  // South
-          {+1, +1},  // Southeast
-      }};
-
-      int alive_neighbours = 0;
-      for (auto &[ relative_x, relative_y ] : neighbours) {
-        int neighbour_x = cell.x + relative_x;
-        int neighbour_y = cell.y + relative_y;
-
-        auto [w, h] = m_grid_size;
-        if (m_grid_wrap) {
-          if (neighbour_x <= 0) { neighbour_x += m_grid_size.x; }
-          if (neighbour_x >= w) { neighbour_x -= m_grid_size.x; }
-          if (neighbour_y <= 0) { neighbour_y += m_grid_size.y; }
-          if (neighbour_y >= h) { neighbour_y -= m_grid_size.y; }
+    // Called once per rendered frame; paces PER_FRAME mode.
+    void frame() {
+      {
+        std::lock_guard lock(m_mutex);
+        if (m_paused || m_pace.type != pace::PER_FRAME) {
+          return;
+        }
+        m_credits = m_pace.count;
+      }
+      m_wake.notify_one();
+    }
+
+    // Moves front() on to the newest published board, if there is one.
+    bool acquire() {
+      return m_boards.acquire();
+    }
+
+    const snapshot& front() const {
+      return m_boards.front();
+    }
+
+    // Hands the statistics of every generation since the last call to f.
+    template <typename F>
+    std::size_t drain(F&& f) {
+      return m_generations.drain(std::forward<F>(f));
+    }
+
+    // Statistics that did not fit on the ring, since the start.
+    uint64_t dropped() const {
+      return m_dropped.load(std::memory_order_relaxed);
+    }
+
+protected:
+    snapshot capture() const {
+      snapshot s;
+      s.size = m_game.size();
+      s.cells.assign(m_game.cells(), m_game.cells() + m_game.n_cells());
+      s.stamps = m_stamps;
+      s.version = m_version;
+      s.number = m_number;
+      s.wrap = m_game.wrapping();
+      s.rule = m_game.rule();
+      s.stats = m_game.statistics();
+      return s;
+    }
+
+    void publish() {
+      snapshot& s = m_boards.back();
+      s.size = m_game.size();
+      s.cells.assign(m_game.cells(), m_game.cells() + m_game.n_cells());
+      s.stamps = m_stamps;
+      s.version = m_version;
+      s.number = m_number;
+      s.wrap = m_game.wrapping();
+      s.rule = m_game.rule();
+      s.stats = m_game.statistics();
+      m_boards.publish();
+    }
+
+    void run() {
+      auto deadline = clock::now();
+
+      while (true) {
+        std::vector<std::function<void(gameoflife&)>> commands;
+        bool advance = false;
+
+        {
+          std::unique_lock lock(m_mutex);
+          while (true) {
+            if (m_stopping) {
+              return;
+            }
+
+            if (!m_commands.empty()) {
+              commands.swap(m_commands);
+              break;
+            }
+
+            if (m_paused || m_pace.type == pace::PER_FRAME) {
+              if (m_credits > 0) {
+                m_credits--;
+                advance = true;
+                break;
+              }
+              m_wake.wait(lock);
+              continue;
+            }
+
+            if (m_pace.type == pace::UNLIMITED) {
+              advance = true;
+              break;
+            }
+
+            auto now = clock::now();
+            if (now >= deadline) {
+              deadline += m_pace.period();
+              if (deadline < now) {
+                deadline = now + m_pace.period(); // Fell behind: skip, don't burst
+              }
+              advance = true;
+              break;
+            }
+            m_wake.wait_until(lock, deadline);
+          }
+        }
+
+        m_version++;
+
+        for (auto& command : commands) {
+          command(m_game);
+        }
+        if (!commands.empty()) {
+          std::fill(m_stamps.begin(), m_stamps.end(), m_version);
         }
-        else {
-          if (neighbour_x <= 0) { continue; };
-          if (neighbour_x >= w) { continue; };
-          if (neighbour_y <= 0) { continue; };
-          if (neighbour_y >= h) { continue; };
+
+        if (advance) {
+          if (!m_generations.push(m_game.update())) {
+            m_dropped.fetch_add(1, std::memory_order_relaxed);
+          }
+          m_number++;
+
+          for (uint32_t i : m_game.flipped()) {
+            m_stamps[i / block_cells] = m_version;
+          }
         }
 
-        if (m_display[xytoi({neighbour_x, neighbour_y})]) {
-          alive_neighbours++;
+        publish();
+      }
+    }
+};
+
+// Images of the board for the viewport, one per level of detail.
+//
+// Level 0 has a texel per cell. Each level above halves both sides and
+// shades a texel by the fraction of its 2^k x 2^k cells that are alive, so
+// a zoomed-out view summarises every cell under a screen pixel instead of
+// sampling one of them. Live counts follow each changed cell; texels are
+// recoloured and uploaded only for rows that changed, and only when their
+// level is drawn.
+class board_images {
+public:
+    static constexpr int max_levels = 12;
+
+protected:
+    struct level {
+      int scale;                    // Cells per texel side
+      gameoflife::vector size;
+      std::vector<uint32_t> alive;  // Live cells per texel; empty at level 0
+      std::vector<uint32_t> pixels; // ARGB8888
+      int dirty_first;              // Rows to upload, if first <= last
+      int dirty_last;
+      SDL_Texture* texture;
+    };
+
+    std::vector<level> m_levels;
+    SDL_Renderer* m_renderer{nullptr};
+
+public:
+    explicit board_images(gameoflife::vector board) {
+      for (int k = 0; k < max_levels; k++) {
+        int scale = 1 << k;
+        gameoflife::vector size{(board.x + scale - 1) / scale, (board.y + scale - 1) / scale};
+        std::size_t texels = static_cast<std::size_t>(size.x) * size.y;
+
+        m_levels.push_back({
+            scale, size,
+            std::vector<uint32_t>(k ? texels : 0),
+            std::vector<uint32_t>(texels, colour(0)),
+            0, size.y - 1,
+            nullptr
+        });
+
+        if (size.x == 1 && size.y == 1) {
+          break;
         }
       }
+    }
+
+    board_images(const board_images&) = delete;
+    board_images& operator=(const board_images&) = delete;
 
-      return alive_neighbours;
+    ~board_images() {
+      release();
     }
 
-    int xytoi(const geometry::vector c) const {
-      return (c.y * m_grid_size.x) + c.x;
+    int levels() const {
+      return static_cast<int>(m_levels.size());
     }
 
-    geometry::vector size() const {
-      return m_grid_size;
+    int scale(int k) const {
+      return m_levels[k].scale;
     }
 
-    bool cell_state(const geometry::vector c) const {
-      return m_display[xytoi(c)];
+    // Cell (x, y) went from one state to another.
+    void set(int x, int y, uint8_t from, uint8_t to) {
+      level& base = m_levels[0];
+      base.pixels[(y * base.size.x) + x] = colour(to);
+      touch(base, y);
+
+      int delta = (to == 1) - (from == 1);
+      if (!delta) {
+        return;
+      }
+
+      for (std::size_t k = 1; k < m_levels.size(); k++) {
+        level& l = m_levels[k];
+        int tx = x >> k, ty = y >> k;
+        l.alive[(ty * l.size.x) + tx] += delta;
+        touch(l, ty);
+      }
     }
 
-    generation update() {
-      generation gen;
-      for (int cy = 0; cy < m_grid_size.y; cy++) {
-        for (int cx = 0; cx < m_grid_size.x; cx++) {
-          int alive_neighbours = alive_neighbours_of({cx, cy});
-          int i = xytoi({cx, cy});
-          bool cell_alive = m_display[i];
+    // Level k's texture, brought up to date; nullptr if the renderer
+    // cannot stream textures.
+    SDL_Texture* texture(SDL_Renderer* renderer, int k) {
+      if (renderer != m_renderer) {
+        release();
+        m_renderer = renderer;
+      }
 
-          if ((cell_alive && (alive_neighbours == 2 || alive_neighbours == 3))
-              || (!cell_alive && alive_neighbours == 3)
-          ) {
-            m_update[i] = true;
-            gen.alive++;
-            continue;
-          }
+      level& l = m_levels[k];
+      if (!l.texture) {
+        l.texture = SDL_CreateTexture(
+            renderer, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_STREAMING,
+            l.size.x, l.size.y
+        );
+        if (!l.texture) {
+          return nullptr;
+        }
+        l.dirty_first = 0;
+        l.dirty_last = l.size.y - 1;
+      }
 
-          m_update[i] = false;
-          gen.dead++;
+      if (l.dirty_first <= l.dirty_last) {
+        if (k > 0) {
+          recolour(l);
         }
+        SDL_Rect rows{0, l.dirty_first, l.size.x, l.dirty_last - l.dirty_first + 1};
+        SDL_UpdateTexture(
+            l.texture, &rows,
+            l.pixels.data() + (static_cast<std::size_t>(l.dirty_first) * l.size.x),
+            l.size.x * sizeof(uint32_t)
+        );
+        l.dirty_first = l.size.y;
+        l.dirty_last = -1;
+      }
+
+      return l.texture;
+    }
+
+    // Grey levels read the same as ARGB texels and as gfx colours.
+    static uint32_t colour(uint8_t state) {
+      switch (state) {
+        case 0:  return 0xff000000;
+        case 1:  return 0xffffffff;
+        default: return 0xff808080; // Dying cells of Generations rules
       }
+    }
 
-      m_display.swap(m_update);
+protected:
+    static void touch(level& l, int row) {
+      l.dirty_first = std::min(l.dirty_first, row);
+      l.dirty_last = std::max(l.dirty_last, row);
+    }
 
-      gen.alive_delta = m_previous_generation.alive - gen.alive;
-      gen.dead_delta  = m_previous_generation.dead  - gen.dead;
+    // Square root, so sparse regions stay visible.
+    static void recolour(level& l) {
+      double full = static_cast<double>(l.scale) * l.scale;
+      std::size_t first = static_cast<std::size_t>(l.dirty_first) * l.size.x;
+      std::size_t last = static_cast<std::size_t>(l.dirty_last + 1) * l.size.x;
+
+      for (std::size_t i = first; i < last; i++) {
+        uint32_t v = static_cast<uint32_t>(255.0 * std::sqrt(l.alive[i] / full));
+        l.pixels[i] = 0xff000000 | (v << 16) | (v << 8) | v;
+      }
+    }
 
-      m_previous_generation = gen;
-      return gen;
+    void release() {
+      for (auto& l : m_levels) {
+        if (l.texture) {
+          SDL_DestroyTexture(l.texture);
+          l.texture = nullptr;
+        }
+      }
     }
 };
 
 class isogameoflife : public isolinear::ui::control {
 protected:
-    std::size_t m_cell_size;
-    gameoflife m_game;
-    layout::grid m_game_grid;
-    geometry::vector m_hover_cell{0};
-    bool m_pause{false};
+    simulation m_simulation;
+    bool m_wrap{true};
+    bool m_cycling{false};
+    uint64_t m_dropped{0};
+    rules::rule m_seen_rule{rules::conway::describe()}; // Last rule signal_rule reported
+
+    std::string m_checkpoint_path;
+    std::chrono::steady_clock::time_point m_next_checkpoint;
+    std::future<void> m_checkpointing;
+
+    // Viewport: m_zoom screen pixels per cell, with the board point
+    // m_centre in the middle of the control.
+    static constexpr double max_zoom = 64;
+    double m_zoom{1};
+    double m_centre_x{0};
+    double m_centre_y{0};
+    std::optional<gameoflife::vector> m_hover_cell;
+
+    bool m_dragging{false};
+    geometry::position m_drag_from;
+
+    struct touch {
+      SDL_FingerID id;
+      geometry::position at;
+    };
+    std::vector<touch> m_touches; // Fingers down on the board; two pinch
+
+    // Board images follow the published boards; only cells that differ
+    // from m_shown are updated.
+    mutable board_images m_images;
+    mutable std::vector<uint8_t> m_shown;
+    mutable uint64_t m_shown_version{0};
 
 public:
-    miso::signal<gameoflife::generation> signal_step;
+    miso::signal<gameoflife::generation> signal_step; // Every generation
+    miso::signal<gameoflife::generation, uint64_t> signal_stats; // Once per frame: the latest, and how many were dropped
+    miso::signal<int> signal_cycle; // Once per cycle, with its period; 1 for a static board
+    miso::signal<rules::rule> signal_rule; // When the board's rule changes, from the UI or a loaded file
 
 public:
-    isogameoflife(isolinear::layout::grid g)
+    // The board can be any size; the viewport starts out fitting all of it.
+    isogameoflife(isolinear::layout::grid g, geometry::vector board_size)
     : control(g)
-    , m_cell_size(5)
-    , m_game({
-        static_cast<int>(floor(g.bounds().W()/m_cell_size)),
-        static_cast<int>(floor(g.bounds().H()/m_cell_size))
-    })
-    , m_game_grid(g.bounds(), {static_cast<int>(m_cell_size)}, 4, m_game.size(), 0)
-    { }
+    , m_simulation(board_size)
+    , m_images({board_size.x, board_size.y})
+    , m_shown(static_cast<std::size_t>(board_size.x) * board_size.y, 0)
+    {
+      fit();
+    }
 
     void initialise(const int factor) {
-      m_game.initialise(factor);
+      m_simulation.apply([factor](gameoflife& game) { game.initialise(factor); });
     }
 
     void mutate(const int factor) {
-      m_game.mutate(factor);
+      m_simulation.apply([factor](gameoflife& game) { game.mutate(factor); });
     }
 
     bool wrap() {
-      return m_game.wrap();
+      m_wrap = !m_wrap;
+      m_simulation.apply([state = m_wrap](gameoflife& game) { game.wrap(state); });
+      return m_wrap;
+    }
+
+    bool wrapping() const {
+      return m_wrap;
+    }
+
+    int n_cells() const {
+      return m_simulation.n_cells();
+    }
+
+    void rule(std::string r) {
+      m_simulation.apply([r = std::move(r)](gameoflife& game) { game.rule(r); });
+    }
+
+    // The rule of the latest published board.
+    const rules::rule& rule() const {
+      return m_simulation.front().rule;
+    }
+
+    // Replaces the board with an RLE or Macrocell pattern file.
+    void load(std::string path) {
+      m_simulation.apply([path = std::move(path)](gameoflife& game) {
+        try {
+          auto h = patterns::load(game, path);
+          isolinear::log::info("Loaded {} ({}x{})", path, h.width, h.height);
+        }
+        catch (std::runtime_error const& e) {
+          isolinear::log::error("{}", e.what());
+        }
+      });
+    }
+
+    // Checkpoints are written to path every checkpoint_interval.
+    static constexpr auto checkpoint_interval = std::chrono::seconds(60);
+
+    void checkpoint_path(std::string path) {
+      m_checkpoint_path = std::move(path);
+      m_next_checkpoint = std::chrono::steady_clock::now() + checkpoint_interval;
+    }
+
+    // Picks up from the checkpoint, if there is one for a board this size.
+    bool resume() {
+      std::optional<checkpoint::state> saved;
+      try {
+        saved = checkpoint::read(m_checkpoint_path);
+      }
+      catch (std::exception const& e) { // Unreadable or corrupt, including bad_alloc
+        isolinear::log::error("{}", e.what());
+      }
+
+      if (!saved || !(saved->size == m_simulation.front().size)) {
+        return false;
+      }
+
+      isolinear::log::info("Resuming from {} at generation {}", m_checkpoint_path, saved->number);
+      m_wrap = saved->wrap;
+      m_simulation.resume(std::move(*saved));
+      return true;
+    }
+
+    // Copies the latest board and leaves compressing and writing it to
+    // the asio thread.
+    std::future<void> checkpoint() {
+      auto const& board = m_simulation.front();
+      checkpoint::state s{board.size, board.wrap, board.rule, board.number, board.stats, board.cells};
+
+      auto task = std::make_shared<std::packaged_task<void()>>(
+          [s = std::move(s), path = m_checkpoint_path]() {
+            try {
+              checkpoint::write(path, checkpoint::encode(s));
+            }
+            catch (std::runtime_error const& e) {
+              isolinear::log::error("{}", e.what());
+            }
+          });
+      auto done = task->get_future();
+      asio::post(isolinear::io_context, [task]() { (*task)(); });
+      return done;
+    }
+
+    void speed(simulation::pace p) {
+      m_simulation.speed(p);
     }
 
     const bool pause() {
-      m_pause = !m_pause;
-      return m_pause;
+      return m_simulation.pause();
     }
 
     void step() {
-      emit signal_step(m_game.update());
+      m_simulation.step();
     }
 
+    // Picks up whatever the simulation finished since the last frame.
     void update() {
-      if (m_pause) {
+      m_simulation.frame();
+
+      std::optional<gameoflife::generation> latest;
+      m_simulation.drain([this, &latest](gameoflife::generation const& gen) {
+        emit signal_step(gen);
+        cycled(gen.period);
+        latest = gen;
+      });
+
+      // After draining, so the board is at least as new as the statistics.
+      m_simulation.acquire();
+
+      // Generations were lost off a full ring; the published board has
+      // the newest statistics, so a cycle is still noticed.
+      uint64_t dropped = m_simulation.dropped();
+      if (dropped != m_dropped) {
+        m_dropped = dropped;
+        latest = m_simulation.front().stats;
+        cycled(latest->period);
+      }
+
+      if (latest) {
+        emit signal_stats(*latest, m_dropped);
+      }
+
+      if (rule() != m_seen_rule) {
+        m_seen_rule = rule();
+        emit signal_rule(m_seen_rule);
+      }
+
+      auto now = std::chrono::steady_clock::now();
+      if (!m_checkpoint_path.empty() && now >= m_next_checkpoint) {
+        bool busy = m_checkpointing.valid()
+                 && m_checkpointing.wait_for(std::chrono::seconds(0)) != std::future_status::ready;
+        if (!busy) {
+          m_checkpointing = checkpoint();
+          m_next_checkpoint = now + checkpoint_interval;
+        }
+      }
+    }
+
+protected:
+    void cycled(int period) {
+      if (period && !m_cycling) {
+        emit signal_cycle(period);
+      }
+      m_cycling = period != 0;
+    }
+
+public:
+    // Zooms out to the whole board.
+    void fit() {
+      auto size = m_simulation.size();
+      m_zoom = std::clamp(fit_zoom(), min_zoom(), max_zoom);
+      m_centre_x = size.x / 2.0;
+      m_centre_y = size.y / 2.0;
+      changed();
+    }
+
+    void on_wheel_event(isolinear::event::wheel event) override {
+      zoom_about(event.position(), std::pow(1.25, event.y()));
+    }
+
+    void on_mouse_down(isolinear::event::pointer event) override {
+      m_dragging = true;
+      m_drag_from = event.position();
+    }
+
+    void on_mouse_up(isolinear::event::pointer event) override {
+      m_dragging = false;
+    }
+
+    // Touches are tracked in on_pointer_event instead.
+    void on_finger_down(isolinear::event::pointer event) override { }
+    void on_finger_up(isolinear::event::pointer event) override { }
+
+    void on_finger_leave(isolinear::event::pointer event) override {
+      std::erase_if(m_touches, [id = event.finger_id()](touch const& t) { return t.id == id; });
+      control::on_finger_leave(event);
+    }
+
+    void on_pointer_event(const isolinear::event::pointer event) override {
+      control::on_pointer_event(event);
+
+      if (event.type() == isolinear::event::FINGER) {
+        on_touch(event);
+      }
+      else if (event.is_mouse_up()) {
+        m_dragging = false; // The registry delivers releases outside the board too
+      }
+      else if (m_dragging && !event.is_mouse_down()) {
+        pan(event.position().subtract(m_drag_from));
+        m_drag_from = event.position();
+      }
+
+      auto [bx, by] = to_board(event.position());
+      auto size = m_simulation.size();
+      if (bx >= 0 && by >= 0 && bx < size.x && by < size.y) {
+        m_hover_cell = gameoflife::vector{static_cast<int>(bx), static_cast<int>(by)};
+      }
+      else {
+        m_hover_cell.reset();
+      }
+    }
+
+    // A board the viewport has not shown yet.
+    bool needs_redraw() const override {
+      return control::needs_redraw() || m_simulation.front().version != m_shown_version;
+    }
+
+    void draw(SDL_Renderer* renderer) const override {
+      follow(m_simulation.front());
+
+      region b = bounds();
+      boxColor(renderer, b.near_x(), b.near_y(), b.far_x(), b.far_y(), 0xff000000);
+
+      int k = detail_level();
+      SDL_Texture* texture = m_images.texture(renderer, k);
+      if (texture) {
+        draw_level(renderer, texture, k);
+      }
+      else {
+        draw_cells(renderer, m_simulation.front());
+      }
+
+      if (m_hover_cell && m_zoom >= 2) {
+        auto [x0, y0] = to_screen(m_hover_cell->x, m_hover_cell->y);
+        auto [x1, y1] = to_screen(m_hover_cell->x + 1, m_hover_cell->y + 1);
+        boxColor(renderer, x0, y0, x1 - 1, y1 - 1, 0xff0000ff);
+      }
+    }
+
+protected:
+    double fit_zoom() const {
+      auto size = m_simulation.size();
+      region b = bounds();
+      return std::min(static_cast<double>(b.W()) / size.x, static_cast<double>(b.H()) / size.y);
+    }
+
+    double min_zoom() const {
+      return std::min(fit_zoom(), 1.0);
+    }
+
+    std::pair<double, double> to_board(geometry::position p) const {
+      region b = bounds();
+      return {
+        m_centre_x + ((p.x - (b.X() + (b.W() / 2.0))) / m_zoom),
+        m_centre_y + ((p.y - (b.Y() + (b.H() / 2.0))) / m_zoom)
+      };
+    }
+
+    std::pair<int, int> to_screen(double bx, double by) const {
+      region b = bounds();
+      return {
+        static_cast<int>(std::lround(b.X() + (b.W() / 2.0) + ((bx - m_centre_x) * m_zoom))),
+        static_cast<int>(std::lround(b.Y() + (b.H() / 2.0) + ((by - m_centre_y) * m_zoom)))
+      };
+    }
+
+    // Keeps the board point under p where it is.
+    void zoom_about(geometry::position p, double factor) {
+      auto [bx, by] = to_board(p);
+      m_zoom = std::clamp(m_zoom * factor, min_zoom(), max_zoom);
+
+      region b = bounds();
+      m_centre_x = bx - ((p.x - (b.X() + (b.W() / 2.0))) / m_zoom);
+      m_centre_y = by - ((p.y - (b.Y() + (b.H() / 2.0))) / m_zoom);
+      keep_centre_on_board();
+    }
+
+    void pan(geometry::vector screen_delta) {
+      m_centre_x -= screen_delta.x / m_zoom;
+      m_centre_y -= screen_delta.y / m_zoom;
+      keep_centre_on_board();
+    }
+
+    void keep_centre_on_board() {
+      auto size = m_simulation.size();
+      m_centre_x = std::clamp(m_centre_x, 0.0, static_cast<double>(size.x));
+      m_centre_y = std::clamp(m_centre_y, 0.0, static_cast<double>(size.y));
+    }
+
+    // One finger pans; two pinch, zooming about their midpoint.
+    void on_touch(isolinear::event::pointer const& event) {
+      auto it = std::find_if(m_touches.begin(), m_touches.end(),
+          [id = event.finger_id()](touch const& t) { return t.id == id; });
+
+      if (event.is_finger_down()) {
+        if (it == m_touches.end()) {
+          m_touches.push_back({event.finger_id(), event.position()});
+        }
         return;
       }
-      step();
+
+      if (!event.is_finger_motion() || it == m_touches.end()) {
+        return;
+      }
+
+      std::size_t i = it - m_touches.begin();
+      if (m_touches.size() == 1) {
+        pan(event.position().subtract(it->at));
+        it->at = event.position();
+        return;
+      }
+      if (i > 1) {
+        it->at = event.position();
+        return;
+      }
+
+      auto distance = [](geometry::position a, geometry::position b) {
+        return std::hypot(a.x - b.x, a.y - b.y);
+      };
+      auto midpoint = [](geometry::position a, geometry::position b) {
+        return geometry::position{(a.x + b.x) / 2, (a.y + b.y) / 2};
+      };
+
+      double before = distance(m_touches[0].at, m_touches[1].at);
+      geometry::position from = midpoint(m_touches[0].at, m_touches[1].at);
+      it->at = event.position();
+      double after = distance(m_touches[0].at, m_touches[1].at);
+      geometry::position to = midpoint(m_touches[0].at, m_touches[1].at);
+
+      pan(to.subtract(from));
+      if (before > 0 && after > 0) {
+        zoom_about(to, after / before);
+      }
     }
 
-    void on_pointer_event(const isolinear::event::pointer event) {
-      m_hover_cell = m_game_grid.cell_at(event.position());
+    // The coarsest level still showing at least one texel per pixel.
+    int detail_level() const {
+      if (m_zoom >= 1) {
+        return 0;
+      }
+      int k = static_cast<int>(std::floor(std::log2(1 / m_zoom)));
+      return std::clamp(k, 0, m_images.levels() - 1);
     }
 
-    void draw(SDL_Renderer* renderer) const {
-      auto [ grid_x, grid_y ] = m_game.size();
-      for (int cy = 0; cy < grid_y; cy++) {
-        for (int cx = 0; cx < grid_x; cx++) {
+    // Copies just the visible part of level k.
+    void draw_level(SDL_Renderer* renderer, SDL_Texture* texture, int k) const {
+      region b = bounds();
+      auto size = m_simulation.size();
+      int scale = m_images.scale(k);
+      int texels_x = (size.x + scale - 1) / scale;
+      int texels_y = (size.y + scale - 1) / scale;
 
-          int cell_colour = (
-              m_game.cell_state({cx, cy})
-              ? 0xffffffff
-              : 0xff000000
-          );
+      auto [left, top] = to_board(b.near());
+      auto [right, bottom] = to_board(b.far());
+      int tx0 = std::clamp(static_cast<int>(std::floor(left / scale)), 0, texels_x);
+      int ty0 = std::clamp(static_cast<int>(std::floor(top / scale)), 0, texels_y);
+      int tx1 = std::clamp(static_cast<int>(std::ceil(right / scale)), 0, texels_x);
+      int ty1 = std::clamp(static_cast<int>(std::ceil(bottom / scale)), 0, texels_y);
+      if (tx0 >= tx1 || ty0 >= ty1) {
+        return;
+      }
+
+      auto [x0, y0] = to_screen(tx0 * scale, ty0 * scale);
+      auto [x1, y1] = to_screen(std::min(tx1 * scale, size.x), std::min(ty1 * scale, size.y));
+      SDL_Rect src{tx0, ty0, tx1 - tx0, ty1 - ty0};
+      SDL_Rect dst{x0, y0, x1 - x0, y1 - y0};
+
+      SDL_Rect previous_clip;
+      bool clipped = SDL_RenderIsClipEnabled(renderer);
+      SDL_RenderGetClipRect(renderer, &previous_clip);
+
+      SDL_Rect clip{b.X(), b.Y(), b.W() + 1, b.H() + 1};
+      SDL_RenderSetClipRect(renderer, &clip);
+      SDL_RenderCopy(renderer, texture, &src, &dst);
+      SDL_RenderSetClipRect(renderer, clipped ? &previous_clip : nullptr);
+    }
+
+    // Fallback for renderers without streaming textures: live cells in
+    // view, sampling one cell per pixel when zoomed out.
+    void draw_cells(SDL_Renderer* renderer, simulation::snapshot const& board) const {
+      region b = bounds();
+      auto [ grid_x, grid_y ] = board.size;
+      int step = std::max(1, static_cast<int>(std::ceil(1 / m_zoom)));
+
+      auto [left, top] = to_board(b.near());
+      auto [right, bottom] = to_board(b.far());
+      int cx0 = std::max(0, static_cast<int>(left)), cx1 = std::min(grid_x, static_cast<int>(right) + 1);
+      int cy0 = std::max(0, static_cast<int>(top)),  cy1 = std::min(grid_y, static_cast<int>(bottom) + 1);
 
-          geometry::vector cell_coord{cx, cy};
-          if (cell_coord == m_hover_cell) {
-            cell_colour = 0xff0000ff;
+      for (int cy = cy0; cy < cy1; cy += step) {
+        for (int cx = cx0; cx < cx1; cx += step) {
+          uint8_t state = board.cells[(cy * grid_x) + cx];
+          if (!state) {
+            continue;
           }
+          auto [x0, y0] = to_screen(cx, cy);
+          auto [x1, y1] = to_screen(cx + step, cy + step);
+          boxColor(renderer, x0, y0, std::max(x0, x1 - 1), std::max(y0, y1 - 1), board_images::colour(state));
+        }
+      }
+    }
+
+    // Cost is proportional to the blocks that changed since the last
+    // frame, not to the board area.
+    void follow(simulation::snapshot const& board) const {
+      if (board.version == m_shown_version) {
+        return;
+      }
+
+      int grid_x = board.size.x;
+      int n = static_cast<int>(board.cells.size());
 
-          auto cell_region = m_game_grid.cell(cx, cy);
+      for (std::size_t b = 0; b < board.stamps.size(); b++) {
+        if (board.stamps[b] <= m_shown_version) {
+          continue;
+        }
 
-          boxColor(
-              renderer,
-              cell_region.near_x(), cell_region.near_y(),
-              cell_region.far_x(), cell_region.far_y(),
-              cell_colour
-          );
+        int first = static_cast<int>(b) * simulation::block_cells;
+        int last = std::min(first + simulation::block_cells, n);
+        for (int i = first; i < last; i++) {
+          if (board.cells[i] == m_shown[i]) {
+            continue;
+          }
+          m_images.set(i % grid_x, i / grid_x, m_shown[i], board.cells[i]);
+          m_shown[i] = board.cells[i];
         }
       }
+
+      m_shown_version = board.version;
     }
 };
 
@@ -285,10 +996,27 @@ int main(int argc, char* argv[]) {
     ui::button &pause_btn = vbbar.add_button("PAUSE");
     ui::button &step_btn = vbbar.add_button("STEP");
     ui::button &wrap_btn = vbbar.add_button("WRAP");
+    ui::button &speed_btn = vbbar.add_button("1/FRAME");
+    ui::button &rule_btn = vbbar.add_button("CONWAY");
 
-  isogameoflife gol(life_grid);
+  isogameoflife gol(life_grid, {1024, 1024});
   window.add(&gol);
 
+  if (const char* path = std::getenv("ISOLINEAR_CHECKPOINT")) {
+    gol.checkpoint_path(path);
+  }
+  else if (const char* home = std::getenv("HOME")) {
+    gol.checkpoint_path(std::string(home) + "/.isolinear-gameoflife.snapshot");
+  }
+  else {
+    gol.checkpoint_path("gameoflife.snapshot");
+  }
+
+  ui::chart graph(graph_grid, 0, gol.n_cells());
+  auto alive_series = graph.add_series(&theme::colour_scheme::active);
+  auto dead_series = graph.add_series(&theme::colour_scheme::light_alternate);
+  window.add(&graph);
+
   miso::connect(randomise_btn.signal_press, [&](){
       gol.initialise(12);
   });
@@ -313,23 +1041,108 @@ int main(int argc, char* argv[]) {
       gol.step();
   });
 
-  wrap_btn.activate();
+  struct speed_setting {
+    const char* label;
+    simulation::pace pace;
+  };
+  std::array<speed_setting, 5> speeds{{
+      {"1/FRAME", simulation::pace::per_frame(1)},
+      {"4/FRAME", simulation::pace::per_frame(4)},
+      {"10/SEC",  simulation::pace::fixed(10)},
+      {"60/SEC",  simulation::pace::fixed(60)},
+      {"MAX",     simulation::pace::unlimited()},
+  }};
+  std::size_t speed_index = 0;
+
+  miso::connect(speed_btn.signal_press, [&](){
+      speed_index = (speed_index + 1) % speeds.size();
+      gol.speed(speeds[speed_index].pace);
+      speed_btn.label(speeds[speed_index].label);
+  });
+
+  struct rule_setting {
+    const char* label;
+    const char* rule;
+  };
+  std::array<rule_setting, 6> rules{{
+      {"CONWAY",    "B3/S23"},
+      {"HIGHLIFE",  "B36/S23"},
+      {"DAY+NIGHT", "B3678/S34678"},
+      {"BRAIN",     "B2/S/C3"},
+      {"STAR WARS", "B2/S345/C4"},
+      {"BOSCO",     "R5,C0,M1,S34..58,B34..45"},
+  }};
+  std::size_t rule_index = 0;
+
+  auto show_rule = [&]() {
+    for (std::size_t i = 0; i < rules.size(); i++) {
+      if (::rules::rule::parse(rules[i].rule) == gol.rule()) {
+        rule_index = i;
+        rule_btn.label(rules[i].label);
+        return;
+      }
+    }
+    rule_btn.label("CUSTOM");
+  };
+
+  miso::connect(rule_btn.signal_press, [&](){
+      rule_index = (rule_index + 1) % rules.size();
+      gol.rule(rules[rule_index].rule);
+      rule_btn.label(rules[rule_index].label);
+  });
+
+  // Loaded files and checkpoints bring their own rule.
+  miso::connect(gol.signal_rule, [&](::rules::rule){
+      show_rule();
+  });
+
+  if (argc > 1) {
+    gol.load(argv[1]);
+  }
+  else {
+    gol.resume();
+  }
+
+  wrap_btn.active(gol.wrapping());
   miso::connect(wrap_btn.signal_press, [&](){
       wrap_btn.active(gol.wrap());
   });
 
+  // Unattended boards that settle into a cycle are nudged with a
+  // mutation; every fourth time they are re-randomised instead.
+  int mutations = 0;
+  miso::connect(gol.signal_cycle, [&](int period){
+    isolinear::log::info("Board cycling with period {}", period);
+    if (++mutations > 3) {
+      mutations = 0;
+      gol.initialise(12);
+    }
+    else {
+      gol.mutate(200);
+    }
+  });
+
   miso::connect(gol.signal_step, [&](gameoflife::generation gen){
-    header_bar.label(fmt::format(
-        "{} alive ({}), {} dead ({})",
-        gen.alive, gen.alive_delta, gen.dead, gen.dead_delta
-    ));
+    graph.push(alive_series, gen.alive);
+    graph.push(dead_series, gen.dead);
+  });
+
+  miso::connect(gol.signal_stats, [&](gameoflife::generation gen, uint64_t dropped){
+    auto label = fmt::format(
+        "{} alive ({}), {} dead ({}), {} active tiles",
+        gen.alive, gen.alive_delta, gen.dead, gen.dead_delta, gen.active_tiles
+    );
+    if (dropped) {
+      label += fmt::format(", {} dropped", dropped);
+    }
+    header_bar.label(label);
   });
 
   while (isolinear::loop()) {
     gol.update();
-    //SDL_Delay(100);
   }
 
+  gol.checkpoint().wait();
   work_guard.reset();
   isolinear::shutdown();
   return 0;
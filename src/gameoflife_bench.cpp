@@ -0,0 +1,235 @@
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "gameoflife.h"
+#include "fmt/core.h"
+
+// Headless throughput benchmark for the Game of Life engines.
+//
+// Runs every engine mode over a matrix of board sizes, starting boards and
+// wrap modes from the same seeded board, reports generations per second
+// and cells per nanosecond, and checks that every engine ends on the same
+// board with the same per-generation statistics. Exits non-zero if any
+// engine disagrees.
+//
+// Starting boards are random soups, which keep most of the board busy,
+// and settled boards of scattered still lifes and oscillators, which is
+// where a long-running board ends up. TILED only pays off on the latter.
+//
+//   gameoflife_bench [--generations N] [--seed S] [--rule RULE] [--quick]
+
+struct engine {
+  const char* name;
+  gameoflife::engine_mode mode;
+};
+
+constexpr std::array<engine, 2> engines{{
+  {"scalar", gameoflife::SCALAR},
+  {"tiled",  gameoflife::TILED},
+}};
+
+// A random soup of the given density, or a settled board when it is 0
+// in which that fraction of the objects oscillate.
+struct start {
+  const char* name;
+  double density;
+  double oscillating;
+};
+
+struct run {
+  double seconds;
+  std::vector<gameoflife::generation> stats;
+  std::vector<uint8_t> board;
+};
+
+// Still lifes and period 2 oscillators in Conway's Life, one in roughly
+// every third slot of a 24 cell grid.
+std::vector<uint8_t> settled(gameoflife::vector size, double oscillating, uint64_t seed) {
+  using shape = std::vector<std::string_view>;
+  static const std::array<shape, 3> still_lifes{{
+      {"oo", "oo"},                         // Block
+      {".oo.", "o..o", ".oo."},             // Beehive
+      {".oo.", "o..o", ".o.o", "..o."},     // Loaf
+  }};
+  static const std::array<shape, 3> oscillators{{
+      {"ooo"},                              // Blinker
+      {".ooo", "ooo."},                     // Toad
+      {"oo..", "oo..", "..oo", "..oo"},     // Beacon
+  }};
+  constexpr int slot = 24;
+
+  std::vector<uint8_t> cells(static_cast<std::size_t>(size.x) * size.y, 0);
+  std::mt19937_64 random(seed);
+  std::bernoulli_distribution oscillates(oscillating);
+
+  for (int sy = 0; sy + slot <= size.y; sy += slot) {
+    for (int sx = 0; sx + slot <= size.x; sx += slot) {
+      if (random() % 3 != 0) {
+        continue;
+      }
+      auto const& shape = oscillates(random)
+                        ? oscillators[random() % oscillators.size()]
+                        : still_lifes[random() % still_lifes.size()];
+      int ox = sx + 4 + static_cast<int>(random() % (slot - 8));
+      int oy = sy + 4 + static_cast<int>(random() % (slot - 8));
+      for (std::size_t y = 0; y < shape.size(); y++) {
+        for (std::size_t x = 0; x < shape[y].size(); x++) {
+          if (shape[y][x] == 'o') {
+            cells[(oy + y) * size.x + (ox + x)] = 1;
+          }
+        }
+      }
+    }
+  }
+  return cells;
+}
+
+run measure(gameoflife::vector size, start from, bool wrap, engine e, int generations, uint64_t seed, const rules::rule& rule) {
+  gameoflife game(size);
+  game.record_flips(false);
+  game.rule(rule);
+  game.wrap(wrap);
+  game.engine(e.mode);
+  game.seed(seed);
+  if (from.density > 0) {
+    game.randomise(from.density);
+  }
+  else {
+    game.cells(settled(size, from.oscillating, seed).data());
+  }
+
+  run r;
+  r.stats.reserve(generations);
+
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < generations; i++) {
+    r.stats.push_back(game.update());
+  }
+  r.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+  r.board.assign(game.cells(), game.cells() + game.n_cells());
+  return r;
+}
+
+// active_tiles describes the work done, not the result, so it may differ.
+bool same_stats(gameoflife::generation const& a, gameoflife::generation const& b) {
+  return a.alive == b.alive
+      && a.dead == b.dead
+      && a.alive_delta == b.alive_delta
+      && a.dead_delta == b.dead_delta
+      && a.hash == b.hash
+      && a.period == b.period;
+}
+
+// The first generation whose statistics differ, or -1.
+int first_difference(run const& a, run const& b) {
+  for (std::size_t i = 0; i < a.stats.size(); i++) {
+    if (!same_stats(a.stats[i], b.stats[i])) {
+      return static_cast<int>(i);
+    }
+  }
+  return -1;
+}
+
+int main(int argc, char* argv[]) {
+  int generations = 100;
+  uint64_t seed = 1;
+  std::string rule_text = "B3/S23";
+  std::vector<int> sizes{128, 512, 1024, 2048};
+  std::vector<start> starts{
+      {"0.10", 0.1, 0}, {"0.30", 0.3, 0}, {"0.50", 0.5, 0},
+      {"settled", 0, 1.0 / 16}, // Mostly still
+      {"blinky", 0, 0.5},       // Oscillators near every tile
+  };
+
+  for (int i = 1; i < argc; i++) {
+    std::string_view arg = argv[i];
+    bool has_value = i + 1 < argc;
+
+    if (arg == "--generations" && has_value) {
+      generations = std::atoi(argv[++i]);
+    }
+    else if (arg == "--seed" && has_value) {
+      seed = std::strtoull(argv[++i], nullptr, 10);
+    }
+    else if (arg == "--rule" && has_value) {
+      rule_text = argv[++i];
+    }
+    else if (arg == "--quick") {
+      sizes = {128, 512};
+      starts = {{"0.30", 0.3, 0}, {"settled", 0, 1.0 / 16}};
+    }
+    else {
+      fmt::print(stderr, "usage: {} [--generations N] [--seed S] [--rule RULE] [--quick]\n", argv[0]);
+      return 2;
+    }
+  }
+
+  auto rule = rules::rule::parse(rule_text);
+  if (!rule || generations < 1) {
+    fmt::print(stderr, "Invalid rule or generation count\n");
+    return 2;
+  }
+
+  fmt::print("{} generations of {}, seed {}\n\n", generations, rule_text, seed);
+  fmt::print("{:>11} {:>7} {:>5}  {:<7} {:>12} {:>9} {:>8}  {}\n",
+      "board", "start", "wrap", "engine", "gens/sec", "cells/ns", "speedup", "check");
+
+  int failures = 0;
+
+  for (int side : sizes) {
+    gameoflife::vector size{side, side};
+    double cells = static_cast<double>(side) * side;
+
+    for (start from : starts) {
+      for (bool wrap : {true, false}) {
+        std::vector<run> runs;
+        for (auto const& e : engines) {
+          runs.push_back(measure(size, from, wrap, e, generations, seed, *rule));
+        }
+
+        for (std::size_t i = 0; i < engines.size(); i++) {
+          run const& r = runs[i];
+          std::string check = "reference";
+
+          if (i > 0) {
+            int gen = first_difference(runs[0], r);
+            if (gen >= 0) {
+              check = fmt::format("FAIL: stats differ at generation {}", gen + 1);
+              failures++;
+            }
+            else if (r.board != runs[0].board) {
+              check = "FAIL: boards differ";
+              failures++;
+            }
+            else {
+              check = "ok";
+            }
+          }
+
+          fmt::print("{:>11} {:>7} {:>5}  {:<7} {:>12.1f} {:>9.3f} {:>7.2f}x  {}\n",
+              fmt::format("{}x{}", side, side), from.name, wrap ? "on" : "off", engines[i].name,
+              generations / r.seconds,
+              (cells * generations) / (r.seconds * 1e9),
+              runs[0].seconds / r.seconds,
+              check
+          );
+        }
+      }
+    }
+  }
+
+  if (failures) {
+    fmt::print("\n{} engine runs disagreed with the reference\n", failures);
+    return 1;
+  }
+
+  fmt::print("\nAll engines agree\n");
+  return 0;
+}
@@ -57,6 +57,14 @@ int main(int argc, char* argv[]) {
   window.add(&norm_progress);
   window.add(&lrge_progress);
 
+  isolinear::animations.value(
+      0, 100, std::chrono::seconds(3),
+      [&](double v){ norm_progress.value(v); },
+      &norm_progress,
+      isolinear::animation::EASE_IN_OUT,
+      isolinear::animation::PING_PONG
+  );
+
   while (isolinear::loop());
 
   work_guard.reset();